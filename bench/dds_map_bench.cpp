@@ -0,0 +1,566 @@
+//
+// Created by Gian Marco Balia
+//
+// bench/dds_map_bench.cpp
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+#include "macros.h"
+#include "dds_transport.h"
+#include "latency_histogram.h"
+#include "map_layer.h"
+
+#include <fastdds/dds/domain/DomainParticipant.hpp>
+#include <fastdds/dds/domain/DomainParticipantFactory.hpp>
+#include <fastdds/dds/publisher/DataWriter.hpp>
+#include <fastdds/dds/publisher/Publisher.hpp>
+#include <fastdds/dds/subscriber/DataReader.hpp>
+#include <fastdds/dds/subscriber/DataReaderListener.hpp>
+#include <fastdds/dds/subscriber/SampleInfo.hpp>
+#include <fastdds/dds/subscriber/Subscriber.hpp>
+#include <fastdds/dds/topic/TypeSupport.hpp>
+
+#include "ObstaclesPubSubTypes.hpp"
+#include "TargetsPubSubTypes.hpp"
+
+/*
+ * Latency and throughput of a map from the publisher to a usable grid, on the legacy Obstacles and Targets
+ * types, swept over map size, obstacle density and transport, all on this host:
+ *     ./dds_map_bench [maps] [transports]        e.g. ./dds_map_bench 200 tcp,udp,shm
+ * For every transport a child process, forked before the parent makes any DDS entity, stands in for the
+ * Blackboard (discovery client, one reader per topic, samples copied into MapLayerSample as its listeners do
+ * and scaled into the grid as it does) and the parent for Obstacles and Targets (discovery server, the
+ * messages built from an occupancy bitset as publish_from_grid does). A map is usable once both its layers
+ * are in the grid: its latency is taken from the start of the publication to that point, on CLOCK_MONOTONIC,
+ * which the two processes share.
+ * For every map size and density:
+ * - latency: one map at a time, the next one once the previous is usable;
+ * - throughput: a burst of maps, as fast as the writers accept them (reliable, KEEP_ALL, bounded queue),
+ *   with the latency of the maps under that load.
+ * The results are written to stdout as JSON, the progress to stderr.
+ */
+
+using namespace eprosima::fastdds::dds;
+
+#define BENCH_IPV4 "127.0.0.1"
+#define BENCH_PORT 12410                    // * Discovery server port, plus the transport
+#define BENCH_MAX_MAPS 10000
+#define BENCH_QUEUE 64                      // * Maps a writer holds before write blocks
+#define BENCH_TARGETS 10
+#define BENCH_MAX_TRANSPORTS 8
+#define WARMUP_MAPS 10
+#define MAP_TIMEOUT std::chrono::seconds(2)    // * For a map, once published
+#define BURST_TIMEOUT std::chrono::seconds(30)  // * For the last map of a burst
+
+static const int map_sizes[] = {100, 200, 400};
+static const double densities[] = {0.002, 0.02, 0.2};
+
+// * Shared by the two processes (anonymous shared mapping made before the fork)
+typedef struct {
+    std::atomic<uint32_t> obstacles;        // * Obstacles samples taken by the subscriber
+    std::atomic<uint32_t> targets;          // * Targets samples taken by the subscriber
+    std::atomic<uint32_t> usable;           // * Maps whose both layers are in the grid
+    uint64_t sent_ns[BENCH_MAX_MAPS];       // * Start of the publication of each map
+    uint64_t usable_ns[BENCH_MAX_MAPS];     // * When each map became usable
+} bench_shared_t;
+
+static volatile sig_atomic_t keep_running = 1;
+
+static void signal_close(int signum) {
+    keep_running = 0;
+}
+
+class MapSubscriber {
+    /*
+     * Stand-in of the Blackboard: the listeners of both readers hand their samples here, and the grid is
+     * rebuilt when the layers of the same map are both in.
+    */
+private:
+    std::mutex mutex_;                      // * The readers may be served by different DDS threads
+    Obstacles obstacles_msg_;
+    Targets targets_msg_;
+    MapLayerSample obstacles_, targets_;
+    char grid_[GAME_HEIGHT][GAME_WIDTH];
+
+    static void scale(char grid[GAME_HEIGHT][GAME_WIDTH], const MapLayerSample &layer, const char symbol) {
+        // * As the Blackboard: the coordinates of the publisher are stretched between their minimum and maximum
+        if (layer.x.empty() || layer.x.size() != layer.y.size()) return;
+        const auto [min_x, max_x] = std::minmax_element(layer.x.begin(), layer.x.end());
+        const auto [min_y, max_y] = std::minmax_element(layer.y.begin(), layer.y.end());
+        const int range_x = *max_x - *min_x > 0 ? *max_x - *min_x : 1;
+        const int range_y = *max_y - *min_y > 0 ? *max_y - *min_y : 1;
+        for (size_t i = 0; i < layer.x.size(); i++) {
+            const int col = std::clamp(GAME_WIDTH * (layer.x[i] - *min_x) / range_x, 0, GAME_WIDTH - 1);
+            const int row = std::clamp(GAME_HEIGHT * (layer.y[i] - *min_y) / range_y, 0, GAME_HEIGHT - 1);
+            grid[row][col] = symbol;
+        }
+    }
+
+    void layer_in(const bool obstacles) {
+        // * The n-th layer of a kind completes the n-th map if the other one is in (the mutex is held)
+        const uint32_t obstacles_taken = obstacles ? ++shared_->obstacles : shared_->obstacles.load();
+        const uint32_t targets_taken = obstacles ? shared_->targets.load() : ++shared_->targets;
+        const uint32_t map = obstacles ? obstacles_taken : targets_taken;
+        if (std::min(obstacles_taken, targets_taken) < map) return;
+        memset(grid_, ' ', sizeof(grid_));
+        scale(grid_, obstacles_, 'o');
+        scale(grid_, targets_, '0');
+        if (map <= BENCH_MAX_MAPS) shared_->usable_ns[map - 1] = latency_now();
+        shared_->usable.store(map, std::memory_order_release);
+    }
+
+public:
+    bench_shared_t *shared_ = nullptr;
+
+    void take(DataReader *reader, const bool obstacles) {
+        // * As the listeners of the Blackboard: the samples are copied into MapLayerSample
+        std::lock_guard<std::mutex> lock(mutex_);
+        SampleInfo info;
+        if (obstacles) {
+            while (reader->take_next_sample(&obstacles_msg_, &info) == RETCODE_OK) {
+                if (!info.valid_data) continue;
+                obstacles_.x.assign(obstacles_msg_.obstacles_x().begin(), obstacles_msg_.obstacles_x().end());
+                obstacles_.y.assign(obstacles_msg_.obstacles_y().begin(), obstacles_msg_.obstacles_y().end());
+                layer_in(true);
+            }
+            return;
+        }
+        while (reader->take_next_sample(&targets_msg_, &info) == RETCODE_OK) {
+            if (!info.valid_data) continue;
+            targets_.x.assign(targets_msg_.targets_x().begin(), targets_msg_.targets_x().end());
+            targets_.y.assign(targets_msg_.targets_y().begin(), targets_msg_.targets_y().end());
+            layer_in(false);
+        }
+    }
+};
+
+class LayerListener : public DataReaderListener {
+public:
+    MapSubscriber *subscriber_ = nullptr;
+    bool obstacles_ = false;
+
+    void on_data_available(DataReader* reader) override {
+        subscriber_->take(reader, obstacles_);
+    }
+};
+
+struct BenchEntities {
+    DomainParticipant *participant = nullptr;
+    Publisher *publisher = nullptr;
+    Subscriber *subscriber = nullptr;
+    Topic *obstacles_topic = nullptr;
+    Topic *targets_topic = nullptr;
+    DataWriter *obstacles_writer = nullptr;
+    DataWriter *targets_writer = nullptr;
+    DataReader *obstacles_reader = nullptr;
+    DataReader *targets_reader = nullptr;
+};
+
+static bool make_participant(BenchEntities &dds, const int transport, const bool server) {
+    /*
+     * Participant, types and topics of a process of the bench.
+     * @param server true for the publisher (discovery server), false for the subscriber (client).
+    */
+    DomainParticipantQos participant_qos = PARTICIPANT_QOS_DEFAULT;
+    const uint16_t port = BENCH_PORT + transport;
+    if (server) {
+        dds_transport_server(participant_qos, transport, BENCH_IPV4, port);
+    } else {
+        dds_transport_client(participant_qos, transport);
+        dds_transport_add_server(participant_qos, transport, BENCH_IPV4, port);
+    }
+    dds.participant = DomainParticipantFactory::get_instance()->create_participant(0, participant_qos);
+    if (dds.participant == nullptr) return false;
+    TypeSupport obstacles_type(new ObstaclesPubSubType());
+    TypeSupport targets_type(new TargetsPubSubType());
+    obstacles_type.register_type(dds.participant, "Obstacles");
+    targets_type.register_type(dds.participant, "Targets");
+    dds.obstacles_topic = dds.participant->create_topic(TOPIC_NAME_OBSTACLES, "Obstacles", TOPIC_QOS_DEFAULT);
+    dds.targets_topic = dds.participant->create_topic(TOPIC_NAME_TARGETS, "Targets", TOPIC_QOS_DEFAULT);
+    return dds.obstacles_topic != nullptr && dds.targets_topic != nullptr;
+}
+
+template <typename Qos>
+static void queue_qos(Qos &qos, const int transport) {
+    // * Every map delivered, and write blocks when BENCH_QUEUE maps are not acknowledged yet
+    qos.reliability().kind = RELIABLE_RELIABILITY_QOS;
+    qos.reliability().max_blocking_time = Duration_t(5, 0);
+    qos.history().kind = KEEP_ALL_HISTORY_QOS;
+    qos.resource_limits().max_samples = BENCH_QUEUE;
+    qos.resource_limits().max_instances = 1;
+    qos.resource_limits().max_samples_per_instance = BENCH_QUEUE;
+    dds_transport_data_sharing(qos, transport);
+}
+
+static void delete_entities(BenchEntities &dds) {
+    if (dds.participant == nullptr) return;
+    if (dds.obstacles_reader != nullptr) dds.subscriber->delete_datareader(dds.obstacles_reader);
+    if (dds.targets_reader != nullptr) dds.subscriber->delete_datareader(dds.targets_reader);
+    if (dds.obstacles_writer != nullptr) dds.publisher->delete_datawriter(dds.obstacles_writer);
+    if (dds.targets_writer != nullptr) dds.publisher->delete_datawriter(dds.targets_writer);
+    if (dds.subscriber != nullptr) dds.participant->delete_subscriber(dds.subscriber);
+    if (dds.publisher != nullptr) dds.participant->delete_publisher(dds.publisher);
+    if (dds.obstacles_topic != nullptr) dds.participant->delete_topic(dds.obstacles_topic);
+    if (dds.targets_topic != nullptr) dds.participant->delete_topic(dds.targets_topic);
+    DomainParticipantFactory::get_instance()->delete_participant(dds.participant);
+}
+
+static int run_subscriber(bench_shared_t *shared, const int transport) {
+    /*
+     * Child: make the grid from every map received, until SIGTERM.
+    */
+    BenchEntities dds;
+    MapSubscriber subscriber;
+    subscriber.shared_ = shared;
+    LayerListener obstacles_listener, targets_listener;
+    obstacles_listener.subscriber_ = &subscriber;
+    obstacles_listener.obstacles_ = true;
+    targets_listener.subscriber_ = &subscriber;
+    int result = EXIT_FAILURE;
+    if (make_participant(dds, transport, false)) {
+        dds.subscriber = dds.participant->create_subscriber(SUBSCRIBER_QOS_DEFAULT, nullptr);
+        DataReaderQos reader_qos = DATAREADER_QOS_DEFAULT;
+        queue_qos(reader_qos, transport);
+        if (dds.subscriber != nullptr) {
+            dds.obstacles_reader = dds.subscriber->create_datareader(dds.obstacles_topic, reader_qos,
+                &obstacles_listener);
+            dds.targets_reader = dds.subscriber->create_datareader(dds.targets_topic, reader_qos, &targets_listener);
+        }
+        if (dds.obstacles_reader != nullptr && dds.targets_reader != nullptr) {
+            result = EXIT_SUCCESS;
+            while (keep_running) {
+                pause();
+            }
+        }
+    }
+    delete_entities(dds);
+    return result;
+}
+
+class MapPublisher {
+    /*
+     * Stand-in of Obstacles and Targets: a random map of a given size and density, published as they do.
+    */
+private:
+    DataWriter *obstacles_writer_, *targets_writer_;
+    Obstacles obstacles_msg_;
+    Targets targets_msg_;
+    std::vector<uint64_t> obstacles_, targets_;  // * Occupancy bitsets, one bit per cell
+    int width_;
+
+    static void to_coordinates(const std::vector<uint64_t> &bits, const int width, std::vector<int32_t> &x,
+        std::vector<int32_t> &y) {
+        // * Visit only the occupied cells, a word of the bitset at a time
+        x.clear();
+        y.clear();
+        for (size_t word = 0; word < bits.size(); word++) {
+            for (uint64_t mask = bits[word]; mask != 0; mask &= mask - 1) {
+                const int index = static_cast<int>(word * 64 + __builtin_ctzll(mask));
+                x.push_back(index % width);
+                y.push_back(index / width);
+            }
+        }
+    }
+
+public:
+    int obstacles_count_ = 0;
+
+    MapPublisher(DataWriter *obstacles_writer, DataWriter *targets_writer)
+        : obstacles_writer_(obstacles_writer)
+        , targets_writer_(targets_writer)
+        , width_(0)
+    { }
+
+    void generate(const int width, const int height, const double density, std::mt19937 &random) {
+        // * Obstacles anywhere but the center, then the targets on free cells
+        const int cells = width * height;
+        const int center = (height / 2) * width + width / 2;
+        width_ = width;
+        obstacles_.assign((cells + 63) / 64, 0);
+        targets_.assign((cells + 63) / 64, 0);
+        std::vector<int> order(cells);
+        for (int i = 0; i < cells; i++) order[i] = i;
+        std::shuffle(order.begin(), order.end(), random);
+        obstacles_count_ = std::min(static_cast<int>(cells * density), cells - BENCH_TARGETS - 1);
+        int next = 0, placed = 0;
+        for (; placed < obstacles_count_; next++) {
+            if (order[next] == center) continue;
+            obstacles_[order[next] / 64] |= (uint64_t)1 << (order[next] % 64);
+            placed++;
+        }
+        for (placed = 0; placed < BENCH_TARGETS; next++) {
+            if (order[next] == center) continue;
+            targets_[order[next] / 64] |= (uint64_t)1 << (order[next] % 64);
+            placed++;
+        }
+    }
+
+    size_t bytes() const {
+        // * CDR size of both samples: encapsulation, two sequences of longs and the count
+        return 2 * (4 + 2 * 4 + 4) + 2 * 4 * (size_t)(obstacles_count_ + BENCH_TARGETS);
+    }
+
+    bool publish() {
+        // * As publish_from_grid: both layers, built from the bitsets
+        to_coordinates(obstacles_, width_, obstacles_msg_.obstacles_x(), obstacles_msg_.obstacles_y());
+        obstacles_msg_.obstacles_number(obstacles_count_);
+        to_coordinates(targets_, width_, targets_msg_.targets_x(), targets_msg_.targets_y());
+        targets_msg_.targets_number(BENCH_TARGETS);
+        return obstacles_writer_->write(&obstacles_msg_) == RETCODE_OK &&
+            targets_writer_->write(&targets_msg_) == RETCODE_OK;
+    }
+};
+
+static bool wait_usable(bench_shared_t *shared, const uint32_t maps, const std::chrono::seconds timeout) {
+    // * Spin (yielding) until the subscriber made the grid of the first maps
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (shared->usable.load(std::memory_order_acquire) < maps) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        sched_yield();
+    }
+    return true;
+}
+
+static void reset(bench_shared_t *shared) {
+    // * Let the samples still in flight (after a timeout) arrive, then count from zero
+    uint32_t usable;
+    do {
+        usable = shared->usable.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    } while (shared->usable.load() != usable);
+    shared->obstacles = 0;
+    shared->targets = 0;
+    shared->usable = 0;
+}
+
+static void print_latency(const char *name, const latency_histogram_t *histogram) {
+    printf("\"%s\": {\"maps\": %llu, \"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f}", name,
+        (unsigned long long)histogram->count, latency_percentile(histogram, 50.0) / 1e3,
+        latency_percentile(histogram, 99.0) / 1e3, histogram->max_ns / 1e3);
+}
+
+static bool run_publisher(bench_shared_t *shared, const int transport, const char *name, const int maps,
+    bool &first) {
+    /*
+     * Parent: every map size and density over a transport, with the subscriber in a child process.
+     * @param first No result printed yet (no comma before the next one).
+     * @return false if the subscriber could not be reached.
+    */
+    BenchEntities dds;
+    if (!make_participant(dds, transport, true)) return false;
+    dds.publisher = dds.participant->create_publisher(PUBLISHER_QOS_DEFAULT, nullptr);
+    if (dds.publisher == nullptr) {
+        delete_entities(dds);
+        return false;
+    }
+    DataWriterQos writer_qos = DATAWRITER_QOS_DEFAULT;
+    queue_qos(writer_qos, transport);
+    dds.obstacles_writer = dds.publisher->create_datawriter(dds.obstacles_topic, writer_qos, nullptr);
+    dds.targets_writer = dds.publisher->create_datawriter(dds.targets_topic, writer_qos, nullptr);
+    if (dds.obstacles_writer == nullptr || dds.targets_writer == nullptr) {
+        delete_entities(dds);
+        return false;
+    }
+    // * Wait for the subscriber on both topics
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    PublicationMatchedStatus obstacles_matched, targets_matched;
+    do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        dds.obstacles_writer->get_publication_matched_status(obstacles_matched);
+        dds.targets_writer->get_publication_matched_status(targets_matched);
+        if (std::chrono::steady_clock::now() > deadline) {
+            fprintf(stderr, "%s: no subscriber matched\n", name);
+            delete_entities(dds);
+            return false;
+        }
+    } while (obstacles_matched.current_count == 0 || targets_matched.current_count == 0);
+
+    MapPublisher publisher(dds.obstacles_writer, dds.targets_writer);
+    std::mt19937 random(1);
+    static latency_histogram_t latency, loaded;
+    for (const int size : map_sizes) {
+        for (const double density : densities) {
+            fprintf(stderr, "%s: %dx%d, density %.3f\n", name, size, size, density);
+            publisher.generate(size, size, density, random);
+            latency_init(&latency, "latency");
+            latency_init(&loaded, "loaded");
+            int lost = 0;
+            // * Latency: one map at a time (the first ones warm up the path)
+            for (int i = 0; i < WARMUP_MAPS + maps; i++) {
+                const uint64_t start = latency_now();
+                shared->sent_ns[i] = start;
+                if (!publisher.publish() || !wait_usable(shared, i + 1, MAP_TIMEOUT)) {
+                    lost++;
+                    break;
+                }
+                if (i >= WARMUP_MAPS) latency_record(&latency, shared->usable_ns[i] - start);
+            }
+            reset(shared);
+            // * Throughput: all the maps at once, the writers block when their queue is full
+            const uint64_t burst_start = latency_now();
+            int sent = 0;
+            for (; sent < maps; sent++) {
+                shared->sent_ns[sent] = latency_now();
+                if (!publisher.publish()) break;
+            }
+            if (!wait_usable(shared, sent, BURST_TIMEOUT)) lost++;
+            const uint32_t usable = shared->usable.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < usable; i++) {
+                latency_record(&loaded, shared->usable_ns[i] - shared->sent_ns[i]);
+            }
+            const double seconds = usable > 0 ? (shared->usable_ns[usable - 1] - burst_start) / 1e9 : 0.0;
+            reset(shared);
+
+            printf("%s\n    {\"transport\": \"%s\", \"width\": %d, \"height\": %d, \"density\": %.3f, "
+                "\"obstacles\": %d, \"targets\": %d, \"bytes\": %zu, ", first ? "" : ",", name, size, size, density,
+                publisher.obstacles_count_, BENCH_TARGETS, publisher.bytes());
+            first = false;
+            print_latency("latency_us", &latency);
+            printf(", ");
+            print_latency("loaded_latency_us", &loaded);
+            printf(", \"throughput\": {\"maps\": %u, \"seconds\": %.6f, \"maps_per_s\": %.1f, \"mb_per_s\": %.2f}, "
+                "\"timeouts\": %d}", usable, seconds, seconds > 0 ? usable / seconds : 0.0,
+                seconds > 0 ? usable * publisher.bytes() / seconds / 1e6 : 0.0, lost);
+            fflush(stdout);
+        }
+    }
+    delete_entities(dds);
+    return true;
+}
+
+typedef struct {
+    const char *name;
+    int transport;
+    pid_t child;                            // * Subscriber of this transport
+    int start_fd;                           // * A byte starts the subscriber, closing it makes the child exit
+} bench_run_t;
+
+static pid_t fork_subscriber(bench_shared_t *shared, bench_run_t *runs, const int index) {
+    /*
+     * Fork the subscriber of a transport. The child waits on a pipe until the publisher of its transport is
+     * about to start, so it makes its participant only then, and never inherits one from the parent.
+     * @param runs The transports, whose start pipes before index are already open.
+     * @return The pid of the child (runs[index].start_fd set), -1 on error.
+    */
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe");
+        return -1;
+    }
+    // * Nothing left to print in the buffer of the child
+    fflush(stdout);
+    const pid_t child = fork();
+    if (child == -1) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (child == 0) {
+        // * Only the parent may start or release the other subscribers
+        for (int i = 0; i < index; i++) {
+            close(runs[i].start_fd);
+        }
+        close(fds[1]);
+        char start;
+        const ssize_t bytes = read(fds[0], &start, 1);
+        close(fds[0]);
+        _exit(bytes == 1 ? run_subscriber(shared, runs[index].transport) : EXIT_SUCCESS);
+    }
+    close(fds[0]);
+    runs[index].start_fd = fds[1];
+    return child;
+}
+
+static int parse_transport(const char *name) {
+    if (strcmp(name, "tcp") == 0) return DDS_TRANSPORT_TCP;
+    if (strcmp(name, "shm") == 0) return DDS_TRANSPORT_SHM;
+    if (strcmp(name, "udp") == 0) return DDS_TRANSPORT_UDP;
+    return -1;
+}
+
+int main(int argc, char *argv[]) {
+    const int maps = argc > 1 ? atoi(argv[1]) : 200;
+    char transports[64];
+    snprintf(transports, sizeof(transports), "%s", argc > 2 ? argv[2] : "tcp,udp,shm");
+    if (maps <= 0 || maps > BENCH_MAX_MAPS - WARMUP_MAPS) {
+        fprintf(stderr, "Usage: %s [maps, at most %d] [transports: tcp,udp,shm]\n", argv[0],
+            BENCH_MAX_MAPS - WARMUP_MAPS);
+        return EXIT_FAILURE;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_close;
+    sigaction(SIGTERM, &sa, NULL);
+    bench_shared_t *shared = static_cast<bench_shared_t *>(mmap(NULL, sizeof(bench_shared_t),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    new (shared) bench_shared_t();
+
+    int result = EXIT_SUCCESS;
+    bench_run_t runs[BENCH_MAX_TRANSPORTS];
+    int count = 0;
+    char *saveptr = NULL;
+    for (char *name = strtok_r(transports, ",", &saveptr); name != NULL; name = strtok_r(NULL, ",", &saveptr)) {
+        const int transport = parse_transport(name);
+        if (transport == -1) {
+            fprintf(stderr, "Unknown transport \"%s\"\n", name);
+            result = EXIT_FAILURE;
+            continue;
+        }
+        if (count == BENCH_MAX_TRANSPORTS) {
+            fprintf(stderr, "Too many transports: \"%s\" skipped\n", name);
+            result = EXIT_FAILURE;
+            continue;
+        }
+        runs[count].name = name;
+        runs[count].transport = transport;
+        count++;
+    }
+    // * Fork all the subscribers before any DDS entity exists: a child forked after the first transport would
+    // * inherit the threads of the participant factory of the parent
+    int forked = 0;
+    for (; forked < count; forked++) {
+        runs[forked].child = fork_subscriber(shared, runs, forked);
+        if (runs[forked].child == -1) {
+            result = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    printf("{\"benchmark\": \"dds_map_bench\", \"grid\": [%d, %d], \"maps\": %d, \"results\": [", GAME_WIDTH,
+        GAME_HEIGHT, maps);
+    bool first = true;
+    for (int i = 0; i < forked; i++) {
+        // * Start the subscriber of this transport, then publish to it
+        if (write(runs[i].start_fd, "s", 1) != 1) {
+            perror("write start");
+            result = EXIT_FAILURE;
+        } else if (!run_publisher(shared, runs[i].transport, runs[i].name, maps, first)) {
+            result = EXIT_FAILURE;
+        }
+        close(runs[i].start_fd);
+        kill(runs[i].child, SIGTERM);
+        waitpid(runs[i].child, NULL, 0);
+        reset(shared);
+    }
+    printf("\n]}\n");
+    munmap(shared, sizeof(bench_shared_t));
+    return result;
+}
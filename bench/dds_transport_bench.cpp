@@ -0,0 +1,363 @@
+//
+// Created by Gian Marco Balia
+//
+// bench/dds_transport_bench.cpp
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "macros.h"
+#include "bitgrid.h"
+#include "dds_transport.h"
+#include "latency_histogram.h"
+#include "map_codec.h"
+
+#include <fastdds/dds/core/LoanableSequence.hpp>
+#include <fastdds/dds/domain/DomainParticipant.hpp>
+#include <fastdds/dds/domain/DomainParticipantFactory.hpp>
+#include <fastdds/dds/publisher/DataWriter.hpp>
+#include <fastdds/dds/publisher/DataWriterListener.hpp>
+#include <fastdds/dds/publisher/Publisher.hpp>
+#include <fastdds/dds/subscriber/DataReader.hpp>
+#include <fastdds/dds/subscriber/DataReaderListener.hpp>
+#include <fastdds/dds/subscriber/SampleInfo.hpp>
+#include <fastdds/dds/subscriber/Subscriber.hpp>
+#include <fastdds/dds/topic/TypeSupport.hpp>
+
+#include "BenchPongPubSubTypes.hpp"
+#include "MapLayerPubSubTypes.hpp"
+
+/*
+ * Round trip of a map layer between two processes of this host over the transport chosen by TRANSPORT_ENV,
+ * run once per transport:
+ *     DRONEGAME_TRANSPORT=tcp ./dds_transport_bench [density] [samples]
+ *     DRONEGAME_TRANSPORT=shm ./dds_transport_bench [density] [samples]
+ *     DRONEGAME_TRANSPORT=udp ./dds_transport_bench [density] [samples]
+ * The parent is a discovery server, as the generators: it publishes an obstacles layer with the given
+ * density (MapLayer over TCP, MapLayerPlain loaned with data-sharing over shared memory) and waits for the
+ * child, a client as the Blackboard, to decode it and answer on a pong topic (BenchPong) with its CPU time.
+ */
+
+using namespace eprosima::fastdds::dds;
+
+#define BENCH_PORT 12399
+#define BENCH_IPV4 "127.0.0.1"
+#define TOPIC_NAME_PING "bench ping"
+#define TOPIC_NAME_PONG "bench pong"
+#define WARMUP_SAMPLES 100
+#define MATCH_TIMEOUT_S 10                  // * Longest wait for the child to match both topics
+
+static volatile sig_atomic_t keep_running = 1;
+
+static void signal_close(int signum) {
+    keep_running = 0;
+}
+
+static uint32_t cpu_us(void) {
+    // * CPU time of this process (user and system), in microseconds
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint32_t)((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec +
+        usage.ru_stime.tv_usec);
+}
+
+static bool decode(const uint8_t encoding, const uint8_t *payload, const size_t size, const int width,
+    const int height, const uint32_t count, std::vector<int32_t> &x, std::vector<int32_t> &y) {
+    // * As the Blackboard listeners: the layer is usable once decoded
+    x.resize(count);
+    y.resize(count);
+    return map_codec_decode(encoding, payload, size, width, height, (int)count, x.data(), y.data()) == 0;
+}
+
+class PongListener : public DataReaderListener {
+public:
+    std::mutex mutex_;
+    std::condition_variable arrived_;
+    uint64_t pongs_ = 0;
+    uint32_t child_cpu_us_ = 0;
+    BenchPong pong_;
+
+    void on_data_available(DataReader* reader) override {
+        SampleInfo info;
+        while (reader->take_next_sample(&pong_, &info) == RETCODE_OK) {
+            if (!info.valid_data) continue;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pongs_++;
+                child_cpu_us_ = pong_.cpu_us();
+            }
+            arrived_.notify_all();
+        }
+    }
+};
+
+class EchoListener : public DataReaderListener {
+private:
+    MapLayer ping_;
+    LoanableSequence<MapLayerPlain> plain_pings_;
+    SampleInfoSeq infos_;
+    BenchPong pong_;
+    std::vector<int32_t> x_, y_;
+
+    void answer() {
+        pong_.sequence(pong_.sequence() + 1);
+        pong_.cpu_us(cpu_us());
+        writer_->write(&pong_);
+    }
+
+public:
+    DataWriter *writer_ = nullptr;
+    bool plain_ = false;
+
+    void on_data_available(DataReader* reader) override {
+        if (plain_) {
+            // * Decoded in place, in the shared segment of the writer
+            while (reader->take(plain_pings_, infos_) == RETCODE_OK) {
+                for (int32_t i = 0; i < infos_.length(); i++) {
+                    const MapLayerPlain &ping = plain_pings_[i];
+                    if (infos_[i].valid_data && decode(ping.encoding(), ping.payload().data(), ping.size(),
+                            ping.width(), ping.height(), ping.count(), x_, y_)) {
+                        answer();
+                    }
+                }
+                reader->return_loan(plain_pings_, infos_);
+            }
+            return;
+        }
+        SampleInfo info;
+        while (reader->take_next_sample(&ping_, &info) == RETCODE_OK) {
+            if (info.valid_data && decode(ping_.encoding(), ping_.payload().data(), ping_.payload().size(),
+                    ping_.width(), ping_.height(), ping_.count(), x_, y_)) {
+                answer();
+            }
+        }
+    }
+};
+
+static int run_child(const int transport) {
+    /*
+     * Client: decode every ping and answer with a pong, until SIGTERM.
+    */
+    const bool plain = transport == DDS_TRANSPORT_SHM;
+    DomainParticipantQos participant_qos = PARTICIPANT_QOS_DEFAULT;
+    dds_transport_client(participant_qos, transport);
+    dds_transport_add_server(participant_qos, transport, BENCH_IPV4, BENCH_PORT);
+    DomainParticipant *participant = DomainParticipantFactory::get_instance()->create_participant(0, participant_qos);
+    if (participant == nullptr) return EXIT_FAILURE;
+    TypeSupport layer_type(new MapLayerPubSubType());
+    TypeSupport plain_type(new MapLayerPlainPubSubType());
+    TypeSupport pong_type(new BenchPongPubSubType());
+    layer_type.register_type(participant, "MapLayer");
+    plain_type.register_type(participant, "MapLayerPlain");
+    pong_type.register_type(participant, "BenchPong");
+    Topic *ping_topic = participant->create_topic(TOPIC_NAME_PING, plain ? "MapLayerPlain" : "MapLayer",
+        TOPIC_QOS_DEFAULT);
+    Topic *pong_topic = participant->create_topic(TOPIC_NAME_PONG, "BenchPong", TOPIC_QOS_DEFAULT);
+    Publisher *publisher = participant->create_publisher(PUBLISHER_QOS_DEFAULT, nullptr);
+    Subscriber *subscriber = participant->create_subscriber(SUBSCRIBER_QOS_DEFAULT, nullptr);
+    DataWriterQos writer_qos = DATAWRITER_QOS_DEFAULT;
+    DataReaderQos reader_qos = DATAREADER_QOS_DEFAULT;
+    dds_transport_data_sharing(writer_qos, transport);
+    dds_transport_data_sharing(reader_qos, transport);
+    reader_qos.reliability().kind = RELIABLE_RELIABILITY_QOS;
+    EchoListener listener;
+    listener.plain_ = plain;
+    listener.writer_ = publisher->create_datawriter(pong_topic, writer_qos, nullptr);
+    DataReader *reader = subscriber->create_datareader(ping_topic, reader_qos, &listener);
+    while (keep_running) {
+        pause();
+    }
+    subscriber->delete_datareader(reader);
+    publisher->delete_datawriter(listener.writer_);
+    participant->delete_subscriber(subscriber);
+    participant->delete_publisher(publisher);
+    participant->delete_topic(ping_topic);
+    participant->delete_topic(pong_topic);
+    DomainParticipantFactory::get_instance()->delete_participant(participant);
+    return EXIT_SUCCESS;
+}
+
+static void random_layer(bitgrid_t *cells, const double density) {
+    bitgrid_clear(cells);
+    for (int index = 0; index < BITGRID_CELLS; index++) {
+        if (rand() < density * RAND_MAX) bitgrid_set(cells->obstacles, index);
+    }
+}
+
+static void measure(DataWriter *writer, PongListener &pongs, const int transport, const double density,
+    const int samples) {
+    /*
+     * Publish the layer to the matched child, one round trip at a time, and print the latency and the CPU time.
+    */
+    const bool plain = transport == DDS_TRANSPORT_SHM;
+    bitgrid_t cells;
+    random_layer(&cells, density);
+    MapLayer ping;
+    MapLayerPlain *fallback = new MapLayerPlain();
+    latency_histogram_t round_trip;
+    latency_init(&round_trip, "round trip");
+    size_t payload_bytes = 0;
+    uint32_t cpu_start = 0, child_cpu_start = 0;
+    int lost = 0;
+    for (int i = 0; i < WARMUP_SAMPLES + samples; i++) {
+        if (i == WARMUP_SAMPLES) {
+            cpu_start = cpu_us();
+            std::lock_guard<std::mutex> lock(pongs.mutex_);
+            child_cpu_start = pongs.child_cpu_us_;
+        }
+        const uint64_t start = latency_now();
+        uint64_t expected;
+        {
+            std::lock_guard<std::mutex> lock(pongs.mutex_);
+            expected = pongs.pongs_ + 1;
+        }
+        uint8_t encoding;
+        if (plain) {
+            void *loaned = nullptr;
+            MapLayerPlain *sample = writer->loan_sample(loaned) == RETCODE_OK ? static_cast<MapLayerPlain *>(loaned) :
+                fallback;
+            payload_bytes = map_codec_encode(cells.obstacles, sample->payload().data(), &encoding);
+            sample->size(static_cast<uint32_t>(payload_bytes));
+            sample->version(MAP_CODEC_VERSION);
+            sample->encoding(encoding);
+            sample->width(GAME_WIDTH);
+            sample->height(GAME_HEIGHT);
+            sample->count(bitgrid_count(cells.obstacles));
+            writer->write(sample);
+        } else {
+            ping.payload().resize(MAP_CODEC_MAX_BYTES);
+            payload_bytes = map_codec_encode(cells.obstacles, ping.payload().data(), &encoding);
+            ping.payload().resize(payload_bytes);
+            ping.version(MAP_CODEC_VERSION);
+            ping.encoding(encoding);
+            ping.width(GAME_WIDTH);
+            ping.height(GAME_HEIGHT);
+            ping.count(bitgrid_count(cells.obstacles));
+            writer->write(&ping);
+        }
+        std::unique_lock<std::mutex> lock(pongs.mutex_);
+        if (!pongs.arrived_.wait_for(lock, std::chrono::seconds(1), [&] { return pongs.pongs_ >= expected; })) {
+            lost++;
+            continue;
+        }
+        lock.unlock();
+        if (i >= WARMUP_SAMPLES) latency_record(&round_trip, latency_now() - start);
+    }
+    const uint32_t cpu = cpu_us() - cpu_start;
+    uint32_t child_cpu;
+    {
+        std::lock_guard<std::mutex> lock(pongs.mutex_);
+        child_cpu = pongs.child_cpu_us_ - child_cpu_start;
+    }
+
+    const uint64_t measured = round_trip.count > 0 ? round_trip.count : 1;
+    const char *name = plain ? "shm (data-sharing, loans)" : transport == DDS_TRANSPORT_UDP ? "udp" : "tcp";
+    printf("transport: %s, density: %.3f, cells: %d, payload: %zu bytes%s\n", name, density,
+        bitgrid_count(cells.obstacles), payload_bytes, plain ? " (MapLayerPlain)" : " (MapLayer)");
+    printf("round trips:           %10llu (%d lost)\n", (unsigned long long)round_trip.count, lost);
+    printf("round trip p50:        %10.1f us\n", latency_percentile(&round_trip, 50.0) / 1e3);
+    printf("round trip p99:        %10.1f us\n", latency_percentile(&round_trip, 99.0) / 1e3);
+    printf("publisher CPU:         %10.1f us/round trip\n", (double)cpu / measured);
+    printf("subscriber CPU:        %10.1f us/round trip\n", (double)child_cpu / measured);
+    delete fallback;
+}
+
+int main(int argc, char *argv[]) {
+    const double density = argc > 1 ? atof(argv[1]) : 0.002;
+    const int samples = argc > 2 ? atoi(argv[2]) : 2000;
+    if (density < 0.0 || density > 1.0 || samples <= 0) {
+        fprintf(stderr, "Usage: %s [density] [samples]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const int transport = dds_transport_mode();
+    const bool plain = transport == DDS_TRANSPORT_SHM;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_close;
+    sigaction(SIGTERM, &sa, NULL);
+    // * Fork before any DDS entity exists
+    const pid_t child = fork();
+    if (child == -1) {
+        perror("fork");
+        return EXIT_FAILURE;
+    }
+    if (child == 0) {
+        return run_child(transport);
+    }
+
+    DomainParticipantQos participant_qos = PARTICIPANT_QOS_DEFAULT;
+    dds_transport_server(participant_qos, transport, BENCH_IPV4, BENCH_PORT);
+    DomainParticipant *participant = DomainParticipantFactory::get_instance()->create_participant(0, participant_qos);
+    if (participant == nullptr) {
+        kill(child, SIGTERM);
+        waitpid(child, NULL, 0);
+        return EXIT_FAILURE;
+    }
+    TypeSupport layer_type(new MapLayerPubSubType());
+    TypeSupport plain_type(new MapLayerPlainPubSubType());
+    TypeSupport pong_type(new BenchPongPubSubType());
+    layer_type.register_type(participant, "MapLayer");
+    plain_type.register_type(participant, "MapLayerPlain");
+    pong_type.register_type(participant, "BenchPong");
+    Topic *ping_topic = participant->create_topic(TOPIC_NAME_PING, plain ? "MapLayerPlain" : "MapLayer",
+        TOPIC_QOS_DEFAULT);
+    Topic *pong_topic = participant->create_topic(TOPIC_NAME_PONG, "BenchPong", TOPIC_QOS_DEFAULT);
+    Publisher *publisher = participant->create_publisher(PUBLISHER_QOS_DEFAULT, nullptr);
+    Subscriber *subscriber = participant->create_subscriber(SUBSCRIBER_QOS_DEFAULT, nullptr);
+    DataWriterQos writer_qos = DATAWRITER_QOS_DEFAULT;
+    DataReaderQos reader_qos = DATAREADER_QOS_DEFAULT;
+    dds_transport_data_sharing(writer_qos, transport);
+    dds_transport_data_sharing(reader_qos, transport);
+    reader_qos.reliability().kind = RELIABLE_RELIABILITY_QOS;
+    PongListener pongs;
+    DataWriter *writer = publisher->create_datawriter(ping_topic, writer_qos, nullptr);
+    DataReader *reader = subscriber->create_datareader(pong_topic, reader_qos, &pongs);
+
+    // * Wait for the child on both topics, as long as it is alive
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(MATCH_TIMEOUT_S);
+    PublicationMatchedStatus published;
+    SubscriptionMatchedStatus subscribed;
+    bool child_alive = true;
+    bool matched = false;
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        writer->get_publication_matched_status(published);
+        reader->get_subscription_matched_status(subscribed);
+        matched = published.current_count > 0 && subscribed.current_count > 0;
+        if (matched) break;
+        if (waitpid(child, NULL, WNOHANG) == child) {
+            fprintf(stderr, "The client exited before matching\n");
+            child_alive = false;
+            break;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            fprintf(stderr, "The client did not match in %d s\n", MATCH_TIMEOUT_S);
+            break;
+        }
+    }
+    if (matched) {
+        measure(writer, pongs, transport, density, samples);
+    }
+
+    subscriber->delete_datareader(reader);
+    publisher->delete_datawriter(writer);
+    participant->delete_subscriber(subscriber);
+    participant->delete_publisher(publisher);
+    participant->delete_topic(ping_topic);
+    participant->delete_topic(pong_topic);
+    DomainParticipantFactory::get_instance()->delete_participant(participant);
+    if (child_alive) {
+        kill(child, SIGTERM);
+        waitpid(child, NULL, 0);
+    }
+    return matched ? EXIT_SUCCESS : EXIT_FAILURE;
+}
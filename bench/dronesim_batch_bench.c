@@ -0,0 +1,107 @@
+//
+// Created by Gian Marco Balia
+//
+// bench/dronesim_batch_bench.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "macros.h"
+#include "dronesim.h"
+#include "dronesim_batch.h"
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void random_map(char grid[GAME_HEIGHT][GAME_WIDTH]) {
+    // * Same density as the game: obstacles on 0.2% of the cells and ten targets
+    memset(grid, ' ', GAME_HEIGHT * GAME_WIDTH);
+    int cells = (int)(GAME_HEIGHT * GAME_WIDTH * 0.002) + 10;
+    while (cells > 0) {
+        const int x = 1 + rand() % (GAME_WIDTH - 2);
+        const int y = 1 + rand() % (GAME_HEIGHT - 2);
+        if (grid[y][x] != ' ') continue;
+        grid[y][x] = cells > 10 ? 'o' : (char)('0' + cells - 1);
+        cells--;
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    /*
+     * Steps per second of dronesim_batch_step with 1, 2, 4, ... threads, against dronesim_step in a loop.
+     * @param argv[1]: Number of environments (default 1024)
+     * @param argv[2]: Frames per measure (default 2000)
+    */
+    const int count = argc > 1 ? atoi(argv[1]) : 1024;
+    const int frames = argc > 2 ? atoi(argv[2]) : 2000;
+    if (count <= 0 || frames <= 0) {
+        fprintf(stderr, "Usage: %s [environments] [frames]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    static char grid[GAME_HEIGHT][GAME_WIDTH];
+    char *keys = malloc((size_t)count * frames);
+    dronesim_state_t *states = malloc((size_t)count * sizeof(dronesim_state_t));
+    if (keys == NULL || states == NULL) {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+    srand(42);
+    for (long i = 0; i < (long)count * frames; i++) {
+        keys[i] = rand() % 4 ? '\0' : "wersdfxcv"[rand() % 9];
+    }
+
+    // * Reference: one environment after the other with the scalar API
+    srand(7);
+    for (int i = 0; i < count; i++) {
+        random_map(grid);
+        dronesim_reset(&states[i], grid);
+    }
+    double t0 = now_s();
+    long steps = 0;
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < count; i++) {
+            if (states[i].outcome != DRONESIM_PLAYING) continue;
+            const dronesim_input_t input = {keys[(long)f * count + i], PHYSICS_SUBSTEPS};
+            dronesim_step(&states[i], &input);
+            steps++;
+        }
+    }
+    const double scalar = steps / (now_s() - t0);
+    printf("environments: %d, frames: %d\n", count, frames);
+    printf("dronesim_step:           %12.0f frames/s\n", scalar);
+
+    const long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        dronesim_batch_t *batch = dronesim_batch_create(count, threads);
+        if (batch == NULL) return EXIT_FAILURE;
+        srand(7);
+        for (int i = 0; i < count; i++) {
+            random_map(grid);
+            dronesim_batch_reset(batch, i, grid);
+        }
+        steps = 0;
+        int playing = count;
+        t0 = now_s();
+        for (int f = 0; f < frames && playing > 0; f++) {
+            steps += playing;
+            playing = dronesim_batch_step(batch, keys + (long)f * count, PHYSICS_SUBSTEPS);
+        }
+        const double batched = steps / (now_s() - t0);
+        // * Same maps and keys: the batch must end where the scalar loop ended
+        int mismatches = 0;
+        for (int i = 0; i < count; i++) {
+            mismatches += batch->x[i] != states[i].drone_pos[2] || batch->y[i] != states[i].drone_pos[3] ||
+                batch->score[i] != states[i].score;
+        }
+        printf("batch, %3d thread(s):    %12.0f frames/s (%.1fx), %d mismatches\n", threads, batched,
+            batched / scalar, mismatches);
+        dronesim_batch_destroy(batch);
+    }
+    free(keys);
+    free(states);
+    return EXIT_SUCCESS;
+}
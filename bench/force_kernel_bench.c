@@ -0,0 +1,153 @@
+//
+// Created by Gian Marco Balia
+//
+// bench/force_kernel_bench.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "macros.h"
+#include "force_field.h"
+#include "force_kernel.h"
+#include "spatial_index.h"
+
+#define NUM_QUERIES 20000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void full_scan_force(const char grid[GAME_HEIGHT][GAME_WIDTH], const int x, const int y, double *Fx,
+    double *Fy) {
+    // * Reference: the original loop of drone_dynamics.c, over the whole map with sqrt/pow per cell
+    for (int i = 0; i < GAME_HEIGHT; i++) {
+        for (int j = 0; j < GAME_WIDTH; j++) {
+            const char cell = grid[i][j];
+            if (cell == ' ') continue;
+            const int dx = x - j;
+            const int dy = y - i;
+            double dist = sqrt((double)dx*dx + (double)dy*dy);
+            dist = dist < MIN_RHO_OBST ? MIN_RHO_OBST : dist;
+            if (dist < RHO_OBST && cell == 'o') {
+                *Fx -= ETA*(1/dist - 1/RHO_OBST)*dx/pow(dist,3);
+                *Fy -= ETA*(1/dist - 1/RHO_OBST)*dy/pow(dist,3);
+                continue;
+            }
+            dist = sqrt((double)dx*dx + (double)dy*dy);
+            dist = dist < MIN_RHO_TRG ? MIN_RHO_TRG : dist;
+            if (dist < RHO_TRG && strchr("0123456789", cell)) {
+                *Fx -= EPSILON*(double)dx/dist;
+                *Fy -= EPSILON*(double)dy/dist;
+            }
+        }
+    }
+}
+
+static void kernel_force(const spatial_index_t *index, const int x, const int y, double *Fx, double *Fy) {
+    // * Same query as drone_dynamics.c: buckets around the drone and precomputed kernels
+    const int radius = FORCE_KERNEL_RADIUS;
+    const int min_bucket_row = (y - radius < 0 ? 0 : y - radius) / SPATIAL_BUCKET_SIZE;
+    const int max_bucket_row = (y + radius >= GAME_HEIGHT ? GAME_HEIGHT - 1 : y + radius) / SPATIAL_BUCKET_SIZE;
+    const int min_bucket_col = (x - radius < 0 ? 0 : x - radius) / SPATIAL_BUCKET_SIZE;
+    const int max_bucket_col = (x + radius >= GAME_WIDTH ? GAME_WIDTH - 1 : x + radius) / SPATIAL_BUCKET_SIZE;
+    for (int bucket_row = min_bucket_row; bucket_row <= max_bucket_row; bucket_row++) {
+        for (int bucket_col = min_bucket_col; bucket_col <= max_bucket_col; bucket_col++) {
+            const spatial_entry_t *end = spatial_index_end(index, bucket_row, bucket_col);
+            for (const spatial_entry_t *e = spatial_index_begin(index, bucket_row, bucket_col); e != end; e++) {
+                force_kernel_apply(e->cell, x - e->x, y - e->y, Fx, Fy);
+            }
+        }
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    /*
+     * Microbenchmark of the force computation of drone_dynamics.c: original loop, kernel tables over the
+     * spatial index and cached force field
+     * @param argv[1]: Percentage of occupied cells (default 2)
+    */
+    const double density = argc > 1 ? atof(argv[1]) / 100.0 : 0.02;
+    static char grid[GAME_HEIGHT][GAME_WIDTH];
+    static spatial_index_t index;
+    static force_field_t field;
+    static bitgrid_t cells;
+    static int qx[NUM_QUERIES], qy[NUM_QUERIES];
+    srand(42);
+    memset(grid, ' ', sizeof(grid));
+    for (int r = 0; r < GAME_HEIGHT; r++) {
+        for (int c = 0; c < GAME_WIDTH; c++) {
+            if (rand() < density * RAND_MAX) {
+                grid[r][c] = rand() % 2 ? 'o' : (char)('0' + rand() % 10);
+            }
+        }
+    }
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        qx[i] = 3 + rand() % (GAME_WIDTH - 5);
+        qy[i] = 3 + rand() % (GAME_HEIGHT - 5);
+    }
+    spatial_index_build(&index, grid);
+    bitgrid_from_chars(&cells, grid);
+
+    double ref_x = 0, ref_y = 0, max_error = 0;
+    double t0 = now_ns();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        full_scan_force(grid, qx[i], qy[i], &ref_x, &ref_y);
+    }
+    const double full_ns = (now_ns() - t0) / NUM_QUERIES;
+
+    double k_x = 0, k_y = 0;
+    t0 = now_ns();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        kernel_force(&index, qx[i], qy[i], &k_x, &k_y);
+    }
+    const double kernel_ns = (now_ns() - t0) / NUM_QUERIES;
+
+    force_field_build(&field, &cells);
+    double f_x = 0, f_y = 0;
+    t0 = now_ns();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        double fx, fy;
+        force_field_at(&field, qx[i], qy[i], &fx, &fy);
+        f_x += fx;
+        f_y += fy;
+    }
+    const double field_ns = (now_ns() - t0) / NUM_QUERIES;
+
+    // * Incremental update: remove the targets one at a time, as the drone does
+    static bitgrid_t updated;
+    updated = cells;
+    int removed = 0;
+    t0 = now_ns();
+    for (int i = bitgrid_next(cells.targets, 0); i >= 0; i = bitgrid_next(cells.targets, i + 1)) {
+        bitgrid_reset(updated.targets, i);
+        force_field_update(&field, &updated);
+        removed++;
+    }
+    const double update_ns = removed ? (now_ns() - t0) / removed : 0;
+    t0 = now_ns();
+    force_field_build(&field, &cells);
+    const double build_ns = now_ns() - t0;
+
+    // * Check that the methods agree on every query
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        double ax = 0, ay = 0, bx = 0, by = 0;
+        full_scan_force(grid, qx[i], qy[i], &ax, &ay);
+        kernel_force(&index, qx[i], qy[i], &bx, &by);
+        max_error = fmax(max_error, fmax(fabs(ax - bx), fabs(ay - by)));
+        force_field_at(&field, qx[i], qy[i], &bx, &by);
+        max_error = fmax(max_error, fmax(fabs(ax - bx), fabs(ay - by)));
+    }
+
+    printf("occupied cells:        %d (%.1f%%)\n", index.count, 100.0 * index.count / (GAME_HEIGHT * GAME_WIDTH));
+    printf("full scan, sqrt/pow:   %10.1f ns/query\n", full_ns);
+    printf("buckets, kernel table: %10.1f ns/query\n", kernel_ns);
+    printf("force field lookup:    %10.1f ns/query\n", field_ns);
+    printf("speedup (kernel/field): %9.1fx / %.1fx\n", full_ns / kernel_ns, full_ns / field_ns);
+    printf("field build:           %10.1f ns\n", build_ns);
+    printf("field target removal:  %10.1f ns/update\n", update_ns);
+    printf("max abs difference:    %10.3g (checksum %g %g %g)\n", max_error, ref_x - k_x, ref_y - k_y, f_x + f_y);
+    return EXIT_SUCCESS;
+}
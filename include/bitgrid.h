@@ -0,0 +1,124 @@
+//
+// Created by Gian Marco Balia
+//
+// bitgrid.h
+#ifndef BITGRID_H
+#define BITGRID_H
+
+#include <stdint.h>
+#include "macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Grid of the game as two bitsets, one bit per cell (index row * GAME_WIDTH + col): obstacles and targets.
+ * Counts are popcounts of 64-bit words and the occupied cells are visited a word at a time, skipping empty
+ * words, with bitgrid_next:
+ *     for (int i = bitgrid_next(bits, 0); i >= 0; i = bitgrid_next(bits, i + 1)) { ... }
+ * The characters of a char grid are classified with the cell-class table (BITGRID_CELL_CLASS).
+ * The bits past GAME_HEIGHT * GAME_WIDTH are always zero.
+ */
+#define BITGRID_CELLS (GAME_HEIGHT * GAME_WIDTH)
+#define BITGRID_WORDS ((BITGRID_CELLS + 63) / 64)
+
+#define CELL_EMPTY 0
+#define CELL_OBSTACLE 1                     // * 'o'
+#define CELL_TARGET 2                       // * '0'-'9'
+
+typedef struct {
+    uint64_t obstacles[BITGRID_WORDS];
+    uint64_t targets[BITGRID_WORDS];
+} bitgrid_t;
+
+// * Cell-class table: class of every char of a grid
+#ifdef __cplusplus
+}
+
+struct bitgrid_cell_class_table_t {
+    unsigned char cell_class[256];
+};
+
+constexpr bitgrid_cell_class_table_t bitgrid_make_cell_class_table() {
+    bitgrid_cell_class_table_t table{};
+    table.cell_class[(unsigned char)'o'] = CELL_OBSTACLE;
+    for (char c = '0'; c <= '9'; c++) {
+        table.cell_class[(unsigned char)c] = CELL_TARGET;
+    }
+    return table;
+}
+
+inline constexpr bitgrid_cell_class_table_t bitgrid_cell_class_table = bitgrid_make_cell_class_table();
+static_assert(bitgrid_cell_class_table.cell_class[(unsigned char)'5'] == CELL_TARGET, "cell-class table");
+#define BITGRID_CELL_CLASS(c) (bitgrid_cell_class_table.cell_class[(unsigned char)(c)])
+
+extern "C" {
+#else
+static const unsigned char bitgrid_cell_class_table[256] = {
+    ['o'] = CELL_OBSTACLE,
+    ['0'] = CELL_TARGET, ['1'] = CELL_TARGET, ['2'] = CELL_TARGET, ['3'] = CELL_TARGET, ['4'] = CELL_TARGET,
+    ['5'] = CELL_TARGET, ['6'] = CELL_TARGET, ['7'] = CELL_TARGET, ['8'] = CELL_TARGET, ['9'] = CELL_TARGET,
+};
+#define BITGRID_CELL_CLASS(c) (bitgrid_cell_class_table[(unsigned char)(c)])
+#endif
+
+void bitgrid_clear(bitgrid_t *cells);
+void bitgrid_from_chars(bitgrid_t *cells, const char grid[GAME_HEIGHT][GAME_WIDTH]);
+
+static inline int bitgrid_index(const int col, const int row) {
+    return row * GAME_WIDTH + col;
+}
+
+static inline int bitgrid_test(const uint64_t *bits, const int index) {
+    return (int)((bits[index / 64] >> (index % 64)) & 1u);
+}
+
+static inline void bitgrid_set(uint64_t *bits, const int index) {
+    bits[index / 64] |= (uint64_t)1 << (index % 64);
+}
+
+static inline void bitgrid_reset(uint64_t *bits, const int index) {
+    bits[index / 64] &= ~((uint64_t)1 << (index % 64));
+}
+
+static inline int bitgrid_count(const uint64_t *bits) {
+    /*
+     * Number of cells set.
+    */
+    int count = 0;
+    for (int word = 0; word < BITGRID_WORDS; word++) {
+        count += __builtin_popcountll(bits[word]);
+    }
+    return count;
+}
+
+static inline int bitgrid_next(const uint64_t *bits, const int from) {
+    /*
+     * First cell set at or after an index.
+     * @return Its index, -1 if there is none.
+    */
+    if (from >= BITGRID_CELLS) return -1;
+    int word = from / 64;
+    uint64_t mask = bits[word] & (~(uint64_t)0 << (from % 64));
+    while (mask == 0) {
+        if (++word == BITGRID_WORDS) return -1;
+        mask = bits[word];
+    }
+    return word * 64 + __builtin_ctzll(mask);
+}
+
+static inline int bitgrid_cell(const bitgrid_t *cells, const int col, const int row) {
+    /*
+     * Class of a cell: CELL_EMPTY, CELL_OBSTACLE or CELL_TARGET.
+    */
+    const int index = bitgrid_index(col, row);
+    return bitgrid_test(cells->obstacles, index) ? CELL_OBSTACLE :
+        (bitgrid_test(cells->targets, index) ? CELL_TARGET : CELL_EMPTY);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // BITGRID_H
@@ -0,0 +1,32 @@
+//
+// Created by Gian Marco Balia
+//
+// dds_qos.h
+#ifndef DDS_QOS_H
+#define DDS_QOS_H
+
+#include <stdio.h>
+#include <fastdds/dds/publisher/Publisher.hpp>
+#include <fastdds/dds/publisher/qos/DataWriterQos.hpp>
+#include <fastdds/dds/subscriber/Subscriber.hpp>
+#include <fastdds/dds/subscriber/qos/DataReaderQos.hpp>
+#include <fastdds/dds/topic/Topic.hpp>
+#include "macros.h"
+
+/*
+ * QoS of the writers and readers of the map topics. The map is durable: TRANSIENT_LOCAL, reliable, KEEP_LAST 1
+ * (per instance for the MapItem topics), so a Blackboard that starts late gets the current map from the
+ * writer history as soon as it is matched, and the publishers need not wait for it.
+ * The QoS can be tuned without rebuilding in the XML profiles file QOS_FILE_ENV (if not set, QOS_FILE_DEFAULT in
+ * the directory of the executable, found through /proc/self/exe): a <data_writer> or <data_reader> profile named
+ * as a topic (e.g. "topic 1 layer") replaces the whole QoS of its writers or readers. Topics with no profile, or
+ * no file, get the defaults above. dds_qos_load writes to the logfile which source is in use.
+ * The data-sharing setting is left to dds_transport_data_sharing, after these.
+ */
+bool dds_qos_load(FILE *log);
+void dds_qos_writer(const eprosima::fastdds::dds::Publisher *publisher, const eprosima::fastdds::dds::Topic *topic,
+    int instances, eprosima::fastdds::dds::DataWriterQos &qos);
+void dds_qos_reader(const eprosima::fastdds::dds::Subscriber *subscriber, const eprosima::fastdds::dds::Topic *topic,
+    int instances, eprosima::fastdds::dds::DataReaderQos &qos);
+
+#endif                                      // DDS_QOS_H
@@ -0,0 +1,38 @@
+//
+// Created by Gian Marco Balia
+//
+// dds_transport.h
+#ifndef DDS_TRANSPORT_H
+#define DDS_TRANSPORT_H
+
+#include <stdint.h>
+#include <fastdds/dds/domain/qos/DomainParticipantQos.hpp>
+#include <fastdds/dds/publisher/qos/DataWriterQos.hpp>
+#include <fastdds/dds/subscriber/qos/DataReaderQos.hpp>
+#include "macros.h"
+
+/*
+ * Transport of the DDS participants of the game, chosen at startup with TRANSPORT_ENV and the same for every
+ * process (Main passes its environment to the children):
+ * - DDS_TRANSPORT_TCP ("tcp", default): discovery servers and data over TCPv4 only, as across hosts.
+ * - DDS_TRANSPORT_SHM ("shm"): discovery servers over TCPv4, data over shared memory between the processes
+ *   of the host, and data-sharing for the bounded types: the compact map layers are sent as MapLayerPlain,
+ *   loaned by the writers in the shared segment and read in place by the readers (zero copy).
+ * - DDS_TRANSPORT_UDP ("udp"): discovery servers and data over UDPv4 only, as across hosts on a LAN.
+ * Only the transports chosen are used: the builtin UDP and shared-memory transports are disabled.
+ */
+#define DDS_TRANSPORT_TCP 0
+#define DDS_TRANSPORT_SHM 1
+#define DDS_TRANSPORT_UDP 2
+
+#define DDS_SHM_SEGMENT_BYTES (2 * 1024 * 1024)  // * Shared-memory transport segment of a participant
+
+int dds_transport_mode();
+void dds_transport_server(eprosima::fastdds::dds::DomainParticipantQos &qos, int mode, const char *ip, uint16_t port);
+void dds_transport_client(eprosima::fastdds::dds::DomainParticipantQos &qos, int mode);
+void dds_transport_add_server(eprosima::fastdds::dds::DomainParticipantQos &qos, int mode, const char *ip,
+    uint16_t port);
+void dds_transport_data_sharing(eprosima::fastdds::dds::DataWriterQos &qos, int mode);
+void dds_transport_data_sharing(eprosima::fastdds::dds::DataReaderQos &qos, int mode);
+
+#endif                                      // DDS_TRANSPORT_H
@@ -0,0 +1,84 @@
+//
+// Created by Gian Marco Balia
+//
+// dronesim.h
+#ifndef DRONESIM_H
+#define DRONESIM_H
+
+#include <time.h>
+#include "macros.h"
+#include "bitgrid.h"
+#include "force_field.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Simulation core of the game (libdronesim): physics, target removal and scoring, without ncurses, pipes
+ * or DDS. The Blackboard and Dynamics processes use its pieces, dronesim_step runs a whole frame.
+ * The physics advances in fixed steps of DRONESIM_STEP_TIME, PHYSICS_SUBSTEPS of them per rendered frame
+ * at FRAME_RATE; a real-time loop asks dronesim_clock_substeps how many steps are due, so a slow frame runs
+ * more steps instead of a longer one. The drone position is continuous (in cells), the grid is not.
+ */
+#define DRONESIM_STEP_TIME (TIME / PHYSICS_SUBSTEPS)                    // * Physics time of a step
+#define DRONESIM_STEP_SECONDS (1.0 / (FRAME_RATE * PHYSICS_SUBSTEPS))   // * Wall-clock time of a step
+
+#define DRONESIM_PLAYING 0
+#define DRONESIM_WON 1                      // * All the targets were taken
+#define DRONESIM_LOST 2                     // * The score dropped to zero
+#define DRONESIM_QUIT 3                     // * The user pressed 'q'
+
+#define DRONESIM_CLEAR_RADIUS 1             // * Cells around the drone where no obstacle appears in a game
+
+typedef struct {
+    char grid[GAME_HEIGHT][GAME_WIDTH];     // * Obstacles ('o') and targets ('0'-'9'), as drawn
+    bitgrid_t cells;                        // * The same obstacles and targets, as bitsets
+    double drone_pos[4];                    // * Previous (x, y) and current (x, y) drone position, in cells
+    int drone_force[2];                     // * Force generated by the user
+    int score;
+    int distance_traveled;
+    int count_obstacles;                    // * Counted at the start of a game, then kept by the new obstacles
+    int count_targets;                      // * Counted at the start of a game, then decreased as they are taken
+    double elapsed_time;                    // * Seconds of game (steps * DRONESIM_STEP_SECONDS)
+    long steps;                             // * Physics steps since the start of the game
+    long frame;
+    int outcome;
+    force_field_t field;                    // * Force of the map, kept in sync with the cells by dronesim_step
+} dronesim_state_t;
+
+typedef struct {
+    char key;                               // * Key pressed in this frame, '\0' if none
+    int substeps;                           // * Physics steps of this frame (PHYSICS_SUBSTEPS at FRAME_RATE)
+} dronesim_input_t;
+
+typedef struct {
+    struct timespec last;                   // * CLOCK_MONOTONIC time of the previous call
+    double accumulator;                     // * Seconds not yet simulated
+} dronesim_clock_t;
+
+static inline int dronesim_cell(const double position) {
+    // * Cell of a drone coordinate (always inside the window, so positive)
+    return (int)(position + 0.5);
+}
+
+void dronesim_reset(dronesim_state_t *state, const char grid[GAME_HEIGHT][GAME_WIDTH]);
+int dronesim_load_map(dronesim_state_t *state, const char grid[GAME_HEIGHT][GAME_WIDTH]);
+int dronesim_set_obstacle(dronesim_state_t *state, int col, int row, int present);
+void dronesim_command(int drone_force[2], char key);
+void dronesim_physics(const force_field_t *field, double pos[4], const int force[2], int substeps);
+int dronesim_remove_targets_on_path(char grid[GAME_HEIGHT][GAME_WIDTH], bitgrid_t *cells, int x0, int y0, int x1,
+    int y1);
+int dronesim_score(int *score, int distance_traveled, double elapsed_time, int count_obstacles, int count_targets,
+    int substeps);
+int dronesim_apply_move(dronesim_state_t *state, const double pos[4], int substeps);
+int dronesim_step(dronesim_state_t *state, const dronesim_input_t *input);
+void dronesim_extrapolate(const double pos[4], int substeps, double *x, double *y);
+void dronesim_clock_start(dronesim_clock_t *clock);
+int dronesim_clock_substeps(dronesim_clock_t *clock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // DRONESIM_H
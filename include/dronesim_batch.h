@@ -0,0 +1,55 @@
+//
+// Created by Gian Marco Balia
+//
+// dronesim_batch.h
+#ifndef DRONESIM_BATCH_H
+#define DRONESIM_BATCH_H
+
+#include "macros.h"
+#include "bitgrid.h"
+#include "force_field.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Many independent games stepped together, for training and evaluation jobs. The drone state is kept as a
+ * structure of arrays (element i of every array belongs to environment i) so that the physics runs as a
+ * straight loop over contiguous arrays, and the environments are split among a pool of threads.
+ * Every environment has its own map and force field (about 165 KB each).
+ * A step gives the same result as dronesim_step on each environment with the same key and substeps.
+ */
+#define DRONESIM_BATCH_BLOCK 256            // * Environments processed together by a thread
+#define DRONESIM_BATCH_ALIGN 64             // * Alignment of the arrays (one cache line)
+
+typedef struct dronesim_pool dronesim_pool_t;
+
+typedef struct {
+    int count;                              // * Number of environments
+    double *x_prev, *y_prev;                // * Drone position before the last physics step (cells)
+    double *x, *y;                          // * Current drone position (cells)
+    int *force_x, *force_y;                 // * Force generated by the user
+    int *score;
+    int *distance_traveled;
+    int *count_obstacles;
+    int *count_targets;
+    int *outcome;                           // * DRONESIM_PLAYING, DRONESIM_WON, ...
+    long *steps;                            // * Physics steps since the start of the game
+    long *frame;
+    double *elapsed_time;
+    bitgrid_t *cells;                       // * Map of each environment
+    force_field_t *field;                   // * Force field of each map
+    dronesim_pool_t *pool;
+} dronesim_batch_t;
+
+dronesim_batch_t *dronesim_batch_create(int count, int num_threads);
+void dronesim_batch_destroy(dronesim_batch_t *batch);
+void dronesim_batch_reset(dronesim_batch_t *batch, int env, const char grid[GAME_HEIGHT][GAME_WIDTH]);
+int dronesim_batch_step(dronesim_batch_t *batch, const char *keys, int substeps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // DRONESIM_BATCH_H
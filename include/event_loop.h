@@ -0,0 +1,42 @@
+//
+// Created by Gian Marco Balia
+//
+// event_loop.h
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Event loop of the Blackboard: one epoll instance waits on every input at once.
+ * - The frame tick is a periodic timerfd on CLOCK_MONOTONIC, so frames do not drift with the work done in them.
+ * - The notification eventfd lets other threads (DDS listeners) wake the loop; writes to it are thread safe.
+ * - Any other file descriptor (pipes) is added with event_loop_add; the event data is the file descriptor.
+ */
+#define EVENT_LOOP_MAX_EVENTS 16
+
+typedef struct {
+    int epoll_fd;
+    int timer_fd;                           // * Frame tick
+    int notify_fd;                          // * Wake-ups from other threads
+} event_loop_t;
+
+int event_loop_open(event_loop_t *loop, double frame_rate);
+void event_loop_close(event_loop_t *loop);
+int event_loop_add(event_loop_t *loop, int fd, uint32_t events);
+int event_loop_remove(event_loop_t *loop, int fd);
+int event_loop_wait(event_loop_t *loop, struct epoll_event *events, int max_events);
+uint64_t event_loop_ticks(event_loop_t *loop);
+void event_loop_notify(int notify_fd);
+uint64_t event_loop_notified(event_loop_t *loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // EVENT_LOOP_H
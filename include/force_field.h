@@ -0,0 +1,65 @@
+//
+// Created by Gian Marco Balia
+//
+// force_field.h
+#ifndef FORCE_FIELD_H
+#define FORCE_FIELD_H
+
+#include <math.h>
+#include "macros.h"
+#include "bitgrid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cached force field of the whole map: fx/fy[row][col] is the total force that the obstacles and targets
+ * exert on a drone in (col, row). It is built once per map and then updated incrementally: a changed cell
+ * only touches its influence neighbourhood (see force_kernel.h).
+ */
+#define FORCE_FIELD_REBUILD_CELLS 64        // * Above this number of changed cells the field is rebuilt
+
+typedef struct {
+    double fx[GAME_HEIGHT][GAME_WIDTH];
+    double fy[GAME_HEIGHT][GAME_WIDTH];
+    bitgrid_t cells;                        // * Map the field was computed from
+} force_field_t;
+
+void force_field_build(force_field_t *field, const bitgrid_t *cells);
+int force_field_update(force_field_t *field, const bitgrid_t *cells);
+
+static inline void force_field_at(const force_field_t *field, const int x, const int y, double *Fx, double *Fy) {
+    /*
+     * Force of the map on a drone in (x, y), zero outside the map.
+    */
+    if (x < 0 || x >= GAME_WIDTH || y < 0 || y >= GAME_HEIGHT) {
+        *Fx = 0;
+        *Fy = 0;
+        return;
+    }
+    *Fx = field->fx[y][x];
+    *Fy = field->fy[y][x];
+}
+
+static inline void force_field_sample(const force_field_t *field, const double x, const double y, double *Fx,
+    double *Fy) {
+    /*
+     * Force of the map on a drone in a continuous position: bilinear interpolation of the four cells around it.
+    */
+    const int col = (int)floor(x), row = (int)floor(y);
+    const double ax = x - col, ay = y - row;
+    double fx00, fy00, fx01, fy01, fx10, fy10, fx11, fy11;
+    force_field_at(field, col, row, &fx00, &fy00);
+    force_field_at(field, col + 1, row, &fx01, &fy01);
+    force_field_at(field, col, row + 1, &fx10, &fy10);
+    force_field_at(field, col + 1, row + 1, &fx11, &fy11);
+    *Fx = (1 - ay) * ((1 - ax) * fx00 + ax * fx01) + ay * ((1 - ax) * fx10 + ax * fx11);
+    *Fy = (1 - ay) * ((1 - ax) * fy00 + ax * fy01) + ay * ((1 - ax) * fy10 + ax * fy11);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // FORCE_FIELD_H
@@ -0,0 +1,56 @@
+//
+// Created by Gian Marco Balia
+//
+// force_kernel.h
+#ifndef FORCE_KERNEL_H
+#define FORCE_KERNEL_H
+
+#include "macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Potential-field kernels: force exerted on the drone by one obstacle or one target, as a function of the
+ * integer offset (dx, dy) of the drone from the cell. The tables are computed at compile time in
+ * src/force_kernel.cpp; offsets outside [-FORCE_KERNEL_RADIUS, FORCE_KERNEL_RADIUS] exert no force.
+ */
+#define FORCE_KERNEL_RADIUS 5               // ! RHO_OBST, RHO_TRG <= FORCE_KERNEL_RADIUS + 1
+#define FORCE_KERNEL_SIDE (2 * FORCE_KERNEL_RADIUS + 1)
+
+typedef struct {
+    double fx[FORCE_KERNEL_SIDE][FORCE_KERNEL_SIDE];    // * Indexed by [dy + RADIUS][dx + RADIUS]
+    double fy[FORCE_KERNEL_SIDE][FORCE_KERNEL_SIDE];
+} force_kernel_t;
+
+extern const force_kernel_t force_kernel_obstacle;
+extern const force_kernel_t force_kernel_target;
+
+static inline void force_kernel_apply(const char cell, const int dx, const int dy, double *Fx, double *Fy) {
+    /*
+     * Accumulate the force of a single map cell on the drone.
+     * @param cell Content of the cell ('o' for obstacles, '0'-'9' for targets).
+     * @param dx, dy Offset of the drone from the cell.
+     * @param Fx, Fy Total force to update.
+    */
+    if (dx < -FORCE_KERNEL_RADIUS || dx > FORCE_KERNEL_RADIUS || dy < -FORCE_KERNEL_RADIUS || dy > FORCE_KERNEL_RADIUS) {
+        return;
+    }
+    const force_kernel_t *kernel;
+    if (cell == 'o') {
+        kernel = &force_kernel_obstacle;
+    } else if (cell >= '0' && cell <= '9') {
+        kernel = &force_kernel_target;
+    } else {
+        return;
+    }
+    *Fx += kernel->fx[dy + FORCE_KERNEL_RADIUS][dx + FORCE_KERNEL_RADIUS];
+    *Fy += kernel->fy[dy + FORCE_KERNEL_RADIUS][dx + FORCE_KERNEL_RADIUS];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // FORCE_KERNEL_H
@@ -0,0 +1,71 @@
+//
+// Created by Gian Marco Balia
+//
+// frame_protocol.h
+#ifndef FRAME_PROTOCOL_H
+#define FRAME_PROTOCOL_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Binary messages exchanged every frame between Blackboard and Dynamics.
+ * Every message starts with a fixed header, followed by a fixed payload for its type:
+ * - FRAME_TYPE_STATE (Blackboard -> Dynamics): frame_state_t.
+ * - FRAME_TYPE_REPLY (Dynamics -> Blackboard): frame_reply_t.
+ * The reply carries the sequence number of the state it answers. The grid is not sent through the pipes:
+ * Dynamics reads it from the shared world segment (world_shm.h).
+ * Dynamics owns the drone position between frames: a state only carries the force and the steps to run, and
+ * the position with FRAME_FLAG_RESET (start of a game). So the Blackboard can send up to FRAME_PIPELINE_DEPTH
+ * states without waiting; replies come back in order.
+ */
+#define FRAME_MAGIC 0x464E5244u             // * "DRNF" in little endian
+#define FRAME_VERSION 4
+
+#define FRAME_FLAG_RESET 0x01               // * Dynamics takes the position of the state
+#define FRAME_PIPELINE_DEPTH 4              // * States sent and not answered yet, at most
+
+#define FRAME_TYPE_STATE 1
+#define FRAME_TYPE_REPLY 2
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t type;
+    uint8_t flags;
+    uint32_t sequence;
+    uint32_t payload_size;                  // * Bytes following the header
+} frame_header_t;
+
+typedef struct __attribute__((packed)) {
+    double x[2], y[2];                      // * Previous and current drone position (cells), with FRAME_FLAG_RESET
+    int32_t force_x, force_y;               // * Force generated by the user
+    uint32_t substeps;                      // * Physics steps to run
+    uint32_t reserved;
+} frame_state_t;
+
+typedef struct __attribute__((packed)) {
+    double x[2], y[2];                      // * Previous and current drone position after the steps
+} frame_reply_t;
+
+static_assert(sizeof(frame_header_t) == 16, "frame_header_t must be 16 bytes");
+static_assert(sizeof(frame_state_t) == 48, "frame_state_t must be 48 bytes");
+static_assert(sizeof(frame_reply_t) == 32, "frame_reply_t must be 32 bytes");
+
+int frame_read_full(int fd, void *buf, size_t size);
+int frame_write_full(int fd, const void *buf, size_t size);
+int frame_send_state(int fd, uint32_t sequence, uint8_t flags, const frame_state_t *state);
+int frame_recv_state(int fd, uint32_t *sequence, uint8_t *flags, frame_state_t *state);
+int frame_send_reply(int fd, uint32_t sequence, const frame_reply_t *reply);
+int frame_recv_reply(int fd, uint32_t *sequence, frame_reply_t *reply);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // FRAME_PROTOCOL_H
@@ -0,0 +1,38 @@
+//
+// Created by Gian Marco Balia
+//
+// grid_renderer.h
+#ifndef GRID_RENDERER_H
+#define GRID_RENDERER_H
+
+#include <ncurses.h>
+#include <vector>
+#include "macros.h"
+
+/*
+ * Renderer of the game map in the Blackboard window. It keeps a shadow copy of the grid and of the window
+ * cells it wrote, so that a frame only writes the window cells whose content changed (drone moved, target
+ * taken, new map). After a resize, or when the window was erased by someone else, it repaints everything.
+ * Grid cell (row, col) is shown in window cell (row * height / GAME_HEIGHT, col * width / GAME_WIDTH); when
+ * several grid cells fall in the same window cell, the drone wins, then the last non-empty cell.
+ */
+class GridRenderer {
+private:
+    int height_, width_;                    // * Window size of the shadow, 0 before the first frame
+    bool repaint_;                          // * Repaint everything at the next frame
+    char grid_[GAME_HEIGHT][GAME_WIDTH];    // * Grid shown in the window
+    int drone_x_, drone_y_;                 // * Drone cell shown in the window
+    std::vector<chtype> screen_;            // * Content written in each window cell
+    std::vector<int> dirty_;                // * Window cells to recompute in this frame
+
+    chtype compute_cell(int screen_row, int screen_col) const;
+    void mark_cell(int row, int col);
+
+public:
+    GridRenderer();
+
+    void invalidate();
+    int draw(WINDOW *win, const char grid[GAME_HEIGHT][GAME_WIDTH], int drone_x, int drone_y);
+};
+
+#endif                                      // GRID_RENDERER_H
@@ -0,0 +1,70 @@
+//
+// Created by Gian Marco Balia
+//
+// latency_histogram.h
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Latency histogram with log-linear buckets (as in HDR histograms): every power of two is split into
+ * LATENCY_SUB_BUCKETS linear buckets, so a value is kept with a relative error below 1/LATENCY_SUB_BUCKETS
+ * (6%) from nanoseconds to hours, in a fixed array. Recording a value is a clz, a shift and an increment,
+ * cheap enough to leave on in every build. Values are in nanoseconds of CLOCK_MONOTONIC (latency_now).
+ * A span is measured as:
+ *     const uint64_t start = latency_now();
+ *     ...
+ *     latency_record(&histogram, latency_now() - start);
+ */
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+typedef struct {
+    const char *name;                       // * Name of the measured stage, used in the reports
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t last_ns;                       // * Latest value recorded
+    uint64_t max_ns;
+    uint64_t buckets[LATENCY_BUCKETS];
+} latency_histogram_t;
+
+static inline uint64_t latency_now(void) {
+    // * Nanoseconds of the monotonic clock
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static inline int latency_bucket(const uint64_t ns) {
+    // * Values below LATENCY_SUB_BUCKETS are exact, then LATENCY_SUB_BUCKETS buckets per power of two
+    if (ns < LATENCY_SUB_BUCKETS) return (int)ns;
+    const int exponent = 63 - __builtin_clzll(ns);
+    const int sub_bucket = (int)(ns >> (exponent - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return (exponent - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS + sub_bucket;
+}
+
+static inline void latency_record(latency_histogram_t *histogram, const uint64_t ns) {
+    histogram->buckets[latency_bucket(ns)]++;
+    histogram->count++;
+    histogram->sum_ns += ns;
+    histogram->last_ns = ns;
+    if (ns > histogram->max_ns) histogram->max_ns = ns;
+}
+
+void latency_init(latency_histogram_t *histogram, const char *name);
+uint64_t latency_percentile(const latency_histogram_t *histogram, double percentile);
+void latency_report(FILE *out, const latency_histogram_t *histograms, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // LATENCY_HISTOGRAM_H
@@ -16,17 +16,32 @@
 #define NUM_CHILD_PIPES 4
 #define NUM_CHILD_PROCESSES 6
 
-#define INSPECTOR_FIFO "/tmp/inspector_fifo"
+#define WORLD_SHM_NAME "/dronegame_world"   // * Shared-memory grid (Blackboard -> Dynamics)
+#define TELEMETRY_SHM_NAME "/dronegame_telemetry"  // * Shared-memory status page (Blackboard -> Inspector)
+#define STATS_FILE "/tmp/blackboard_stats.txt"  // * Frame latency per stage, rewritten every STATS_PERIOD
+#define STATS_PERIOD 5.0                    // * Seconds
+#define MAP_PERIOD_MS 500                   // * A new map from Obstacles every period (0: only the first one)
+#define MAP_PERIOD_ENV "DRONEGAME_MAP_PERIOD_MS"  // * Environment variable overriding MAP_PERIOD_MS
+#define MAP_FORMAT_ENV "DRONEGAME_MAP_FORMAT"  // * Map types on the wire (defaults in map_codec.h)
+#define TRANSPORT_ENV "DRONEGAME_TRANSPORT"  // * DDS transport: tcp (default), shm or udp (dds_transport.h)
+#define QOS_FILE_ENV "DRONEGAME_QOS_FILE"  // * XML QoS profiles of the map topics (dds_qos.h)
+#define QOS_FILE_DEFAULT "dronegame_qos.xml"  // * Profiles next to the executables, if QOS_FILE_ENV is not set
 
 // * Obstacles Server
 #define TCP_LISTENING_PORT_OBSTACLES 12345
 #define IPV4_OBSTACLES_SERVER "127.0.0.1"
 #define TOPIC_NAME_OBSTACLES "topic 1"
+#define TOPIC_NAME_OBSTACLES_LAYER "topic 1 layer"  // * Compact MapLayer type (map_codec.h)
+#define TOPIC_NAME_OBSTACLES_ITEMS "topic 1 items"  // * Keyed MapItem type, one instance per obstacle
+#define TOPIC_NAME_OBSTACLES_PLAIN "topic 1 plain"  // * Bounded MapLayerPlain type (shared-memory transport)
 
 // * Targets Server
 #define TCP_LISTENING_PORT_TARGETS 12346
 #define IPV4_TARGETS_SERVER "127.0.0.1"
 #define TOPIC_NAME_TARGETS "topic 2"
+#define TOPIC_NAME_TARGETS_LAYER "topic 2 layer"  // * Compact MapLayer type (map_codec.h)
+#define TOPIC_NAME_TARGETS_ITEMS "topic 2 items"  // * Keyed MapItem type, one instance per target
+#define TOPIC_NAME_TARGETS_PLAIN "topic 2 plain"  // * Bounded MapLayerPlain type (shared-memory transport)
 
 // * Blackboard Client
 #define SERVER_PORT_OBSTACLES 12345         // ! <-TCP_LISTENING_PORT_OBSTACLES
@@ -45,7 +60,9 @@
 // * Physic parameters
 #define DRONE_MASS 1.0
 #define DAMPING 1.0
-#define TIME 10.0
+#define TIME 10.0                           // * Physics time of a rendered frame
+#define PHYSICS_SUBSTEPS 4                  // * Fixed physics steps per rendered frame
+#define PHYSICS_MAX_SUBSTEPS 32             // * Steps run at most in a frame: a longer stall is dropped
 // * Obstacles' repulsive force
 #define ETA 3.0                             // * Repulsion scaling factor
 #define RHO_OBST 6.0                        // * Influence distance for repulsion
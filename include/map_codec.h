@@ -0,0 +1,56 @@
+//
+// Created by Gian Marco Balia
+//
+// map_codec.h
+#ifndef MAP_CODEC_H
+#define MAP_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bitgrid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compact wire format of a map layer (obstacles or targets), the payload of the MapLayer IDL type.
+ * A layer is encoded in the smaller of two forms, so the choice follows the density of the map:
+ * - MAP_ENCODING_PAIRS: the (col, row) of every occupied cell as two little-endian uint16, 4 bytes per cell,
+ *   for sparse maps.
+ * - MAP_ENCODING_RLE: the lengths of the runs of the row-major occupancy bitmap as LEB128 varints, alternating
+ *   empty and occupied runs and starting with an empty one (the trailing empty run is omitted), for dense or
+ *   clustered maps.
+ * The legacy Obstacles and Targets types (two sequence<long>, 8 bytes per cell) are still published and read
+ * during the migration, and the keyed MapItem topics carry only the cells that changed, as chosen by
+ * MAP_FORMAT_ENV (map_codec_format).
+ */
+#define MAP_CODEC_VERSION 1                 // * Bumped on any incompatible change of the payload
+#define MAP_ENCODING_PAIRS 0
+#define MAP_ENCODING_RLE 1
+
+#define MAP_CODEC_MAX_CELLS (1 << 22)       // * Largest map accepted by the decoder
+#define MAP_CODEC_VARINT_BYTES 5            // * Longest varint of a uint32
+#define MAP_CODEC_MAX_BYTES (4 * BITGRID_CELLS + 2 * MAP_CODEC_VARINT_BYTES)  // * Payload of a bitgrid layer
+
+// * Map formats on the wire (MAP_FORMAT_ENV: a comma-separated list of "compact", "legacy", "items", or "both")
+#define MAP_FORMAT_COMPACT 0x1              // * MapLayer samples, the whole layer
+#define MAP_FORMAT_LEGACY 0x2               // * Obstacles and Targets samples, the whole layer
+#define MAP_FORMAT_ITEMS 0x4                // * MapItem instances, written and disposed as the cells change
+#define MAP_FORMAT_BOTH (MAP_FORMAT_COMPACT | MAP_FORMAT_LEGACY)
+// * Formats when MAP_FORMAT_ENV is not set. During the migration the publishers send both types, so a Blackboard
+// * still reading "topic 1"/"topic 2" keeps getting its map; once every Blackboard reads the compact layer,
+// * MAP_FORMAT_PUBLISH_DEFAULT is switched to MAP_FORMAT_COMPACT and the legacy writers go quiet.
+#define MAP_FORMAT_PUBLISH_DEFAULT MAP_FORMAT_BOTH
+#define MAP_FORMAT_READ_DEFAULT MAP_FORMAT_COMPACT
+
+size_t map_codec_encode(const uint64_t *bits, uint8_t *payload, uint8_t *encoding);
+int map_codec_decode(uint8_t encoding, const uint8_t *payload, size_t size, int width, int height, int count,
+    int32_t *x, int32_t *y);
+int map_codec_format(int fallback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // MAP_CODEC_H
@@ -0,0 +1,35 @@
+//
+// Created by Gian Marco Balia
+//
+// map_layer.h
+#ifndef MAP_LAYER_H
+#define MAP_LAYER_H
+
+#include <stdint.h>
+#include <vector>
+
+/*
+ * A layer of the map (obstacles or targets) as received from DDS, independent of the IDL types: the
+ * listeners copy each sample into it, and the game loop builds the grid from the newest obstacles and
+ * targets layers. Coordinates are in the space of the publisher and are scaled to the grid by the reader.
+ */
+struct MapLayerSample {
+    std::vector<int32_t> x, y;
+    uint64_t sequence = 0;                  // * Samples received by the listener, this one included
+
+    bool same_cells(const MapLayerSample &other) const {
+        return x == other.x && y == other.y;
+    }
+};
+
+/*
+ * A change of a single cell of a layer, as received from the keyed MapItem topics: the item appeared (or
+ * moved there) if alive, otherwise it was removed. Like MapLayerSample, it is independent of the IDL types.
+ */
+struct MapItemDelta {
+    int32_t x, y;                           // * Cell in the space of the publisher
+    int32_t width, height;                  // * Map size of the publisher
+    bool alive;
+};
+
+#endif                                      // MAP_LAYER_H
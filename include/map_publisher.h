@@ -0,0 +1,92 @@
+//
+// Created by Gian Marco Balia
+//
+// map_publisher.h
+#ifndef MAP_PUBLISHER_H
+#define MAP_PUBLISHER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <fastdds/dds/domain/DomainParticipant.hpp>
+#include <fastdds/dds/publisher/DataWriter.hpp>
+#include <fastdds/dds/publisher/DataWriterListener.hpp>
+#include <fastdds/dds/publisher/Publisher.hpp>
+#include <fastdds/dds/topic/TypeSupport.hpp>
+#include "bitgrid.h"
+#include "publish_scheduler.h"
+#include "MapItemPubSubTypes.hpp"
+#include "MapLayerPubSubTypes.hpp"
+
+/*
+ * DDS server of a map process (Obstacles or Targets): it publishes one plane of a bitgrid, in every format of
+ * MAP_FORMAT_ENV, on the topics of the process:
+ * - MAP_FORMAT_LEGACY: the legacy Obstacles or Targets type, whose sample the process fills in legacy_sample;
+ * - MAP_FORMAT_COMPACT: MapLayer encoded by map_codec.h, or MapLayerPlain loaned in the shared segment with
+ *   DDS_TRANSPORT_SHM;
+ * - MAP_FORMAT_ITEMS: MapItem, an instance per cell, written and disposed only for the cells that changed.
+ * The writers are durable (dds_qos.h). After a reader matched a VOLATILE one, the next map sends every item,
+ * and the scheduler given to resync_with, if any, is asked for that map at once.
+ */
+struct MapPublisherTopics {
+    const char *name;                       // * Process, in the errors, and registered name of the legacy type
+    const char *ip;                         // * Discovery server of the participant
+    uint16_t port;
+    int plane;                              // * CELL_OBSTACLE or CELL_TARGET: the plane of the bitgrid published
+    const char *legacy;                     // * Topics of each format
+    const char *layer;
+    const char *plain;
+    const char *items;
+};
+
+class MapPublisher {
+private:
+    // * DDS Messages (defined in MapLayer.idl and MapItem.idl)
+    MapLayer layer_message_;
+    MapItem item_message_;
+    MapLayerPlain plain_message_;           // * Used only if no sample can be loaned
+    const MapPublisherTopics topics_;
+    eprosima::fastdds::dds::DomainParticipant* participant_;
+    eprosima::fastdds::dds::Publisher* publisher_;
+    eprosima::fastdds::dds::Topic* topic_;
+    eprosima::fastdds::dds::Topic* layer_topic_;
+    eprosima::fastdds::dds::Topic* items_topic_;
+    eprosima::fastdds::dds::DataWriter* writer_;        // * Legacy type, nullptr if not published
+    eprosima::fastdds::dds::DataWriter* layer_writer_;  // * Compact MapLayer type, nullptr if not published
+    eprosima::fastdds::dds::DataWriter* items_writer_;  // * Keyed MapItem type, nullptr if not published
+    eprosima::fastdds::dds::TypeSupport type_;
+    eprosima::fastdds::dds::TypeSupport layer_type_;
+    eprosima::fastdds::dds::TypeSupport item_type_;
+    eprosima::fastdds::dds::TypeSupport plain_type_;
+    uint64_t items_published_[BITGRID_WORDS];  // * Cells alive on the MapItem topic
+    int format_;                            // * MAP_FORMAT_* flags
+    int transport_;                         // * DDS_TRANSPORT_TCP, DDS_TRANSPORT_SHM or DDS_TRANSPORT_UDP
+    bool plain_;                            // * layer_writer_ writes MapLayerPlain (loaned) rather than MapLayer
+
+    class PubListener : public eprosima::fastdds::dds::DataWriterListener {
+    public:
+        PublishScheduler *scheduler_;       // * Asked for a map when a reader matches, nullptr if none
+        std::atomic_bool resync_;           // * A reader matched since the last publication: send every item
+        PubListener() : scheduler_(nullptr), resync_(false) {}
+        ~PubListener() override {}
+
+        void on_publication_matched(eprosima::fastdds::dds::DataWriter* writer,
+            const eprosima::fastdds::dds::PublicationMatchedStatus& info) override;
+    } listener_;
+
+    void publish_plain(const uint64_t *bits);
+    void publish_items(const uint64_t *bits);
+
+protected:
+    MapPublisher(const MapPublisherTopics &topics, eprosima::fastdds::dds::TopicDataType *legacy_type);
+    void resync_with(PublishScheduler *scheduler);
+    // * Fill the sample of the legacy type with the cells of bits and return it
+    virtual void *legacy_sample(const uint64_t *bits) = 0;
+
+public:
+    virtual ~MapPublisher();
+    bool init(FILE *log);
+    void publish_from_grid(const bitgrid_t *cells);
+};
+
+#endif                                      // MAP_PUBLISHER_H
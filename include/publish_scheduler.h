@@ -0,0 +1,42 @@
+//
+// Created by Gian Marco Balia
+//
+// publish_scheduler.h
+#ifndef PUBLISH_SCHEDULER_H
+#define PUBLISH_SCHEDULER_H
+
+#include <signal.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/*
+ * Decides when a map publisher writes, without polling: the publishing thread sleeps on a condition
+ * variable until a publication is due, either because the period elapsed or because the data changed
+ * (notify_change). A period of zero publishes on change only.
+ * It does not wait for the readers: the map writers are durable (dds_qos.h), and a reader matched later gets
+ * the last map from the writer history. A writer listener can ask for a publication with notify_change.
+ * The stop flag is set by a signal handler, which cannot notify the condition variable: it is checked at
+ * least every STOP_CHECK while waiting.
+ */
+class PublishScheduler {
+private:
+    static constexpr std::chrono::milliseconds STOP_CHECK{250};
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool changed_;                          // * Data changed since the last publication
+    std::chrono::milliseconds period_;
+    std::chrono::steady_clock::time_point next_;
+    const volatile sig_atomic_t *keep_running_;
+
+public:
+    PublishScheduler(std::chrono::milliseconds period, const volatile sig_atomic_t *keep_running);
+
+    void notify_change();
+    bool wait();
+
+    static std::chrono::milliseconds period_from_env(const char *name, std::chrono::milliseconds fallback);
+};
+
+#endif                                      // PUBLISH_SCHEDULER_H
@@ -0,0 +1,52 @@
+//
+// Created by Gian Marco Balia
+//
+// seqlock.h
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Single writer sequence lock, usable across processes (e.g. inside a shared-memory segment).
+ * The sequence is odd while the writer is updating the protected data: readers copy the data and retry
+ * if the sequence was odd or changed meanwhile. Readers never block the writer.
+ */
+typedef struct {
+    uint32_t sequence;
+} seqlock_t;
+
+static inline void seqlock_write_begin(seqlock_t *lock) {
+    __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void seqlock_write_end(seqlock_t *lock) {
+    __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t seqlock_read_begin(const seqlock_t *lock) {
+    uint32_t sequence;
+    // * Wait for the writer to complete the current update
+    while ((sequence = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE)) & 1u) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    return sequence;
+}
+
+static inline int seqlock_read_retry(const seqlock_t *lock, uint32_t sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED) != sequence;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // SEQLOCK_H
@@ -0,0 +1,51 @@
+//
+// Created by Gian Marco Balia
+//
+// spatial_index.h
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Uniform bucket grid over the occupied cells of the game map.
+ * The bucket side is at least the largest influence radius, so a query around a point only has to visit
+ * the 3x3 block of buckets that contains it, independently of the size of the world.
+ */
+#define SPATIAL_BUCKET_SIZE 6               // ! >= RHO_OBST and RHO_TRG
+#define SPATIAL_BUCKET_ROWS ((GAME_HEIGHT + SPATIAL_BUCKET_SIZE - 1) / SPATIAL_BUCKET_SIZE)
+#define SPATIAL_BUCKET_COLS ((GAME_WIDTH + SPATIAL_BUCKET_SIZE - 1) / SPATIAL_BUCKET_SIZE)
+
+typedef struct {
+    short x, y;                             // * Column and row of the cell
+    char cell;                              // * Content of the cell ('o' or a target digit)
+} spatial_entry_t;
+
+typedef struct {
+    // * Entries of bucket b are entries[bucket_start[b]] ... entries[bucket_start[b+1]-1]
+    int bucket_start[SPATIAL_BUCKET_ROWS * SPATIAL_BUCKET_COLS + 1];
+    spatial_entry_t entries[GAME_HEIGHT * GAME_WIDTH];
+    int count;
+} spatial_index_t;
+
+void spatial_index_build(spatial_index_t *index, const char grid[GAME_HEIGHT][GAME_WIDTH]);
+
+static inline const spatial_entry_t *spatial_index_begin(const spatial_index_t *index, int bucket_row,
+    int bucket_col) {
+    return &index->entries[index->bucket_start[bucket_row * SPATIAL_BUCKET_COLS + bucket_col]];
+}
+
+static inline const spatial_entry_t *spatial_index_end(const spatial_index_t *index, int bucket_row,
+    int bucket_col) {
+    return &index->entries[index->bucket_start[bucket_row * SPATIAL_BUCKET_COLS + bucket_col + 1]];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // SPATIAL_INDEX_H
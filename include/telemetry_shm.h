@@ -0,0 +1,61 @@
+//
+// Created by Gian Marco Balia
+//
+// telemetry_shm.h
+#ifndef TELEMETRY_SHM_H
+#define TELEMETRY_SHM_H
+
+#include <stdint.h>
+#include "macros.h"
+#include "seqlock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * POSIX shared-memory status page of the game (TELEMETRY_SHM_NAME), created by Main.
+ * The Blackboard is the only writer: it updates the page under a seqlock after every frame, with no system
+ * call. The inspector window, and any other monitoring tool, maps it read-only and copies it at its own rate
+ * with telemetry_shm_read; the frame counter and stats_seq tell whether anything changed.
+ */
+#define TELEMETRY_MAX_STAGES 8
+#define TELEMETRY_STAGE_NAME 16
+
+typedef struct {
+    char name[TELEMETRY_STAGE_NAME];        // * Empty for unused stages
+    uint64_t count;
+    uint64_t last_ns;                       // * Latest sample
+    uint64_t p50_ns, p99_ns;                // * Refreshed about once per second
+    uint64_t max_ns;
+} telemetry_stage_t;
+
+typedef struct {
+    uint64_t frame;                         // * Drone updates since the start of the game
+    uint64_t stats_seq;                     // * Refreshes of the percentiles, also while no frame runs
+    int32_t force_x, force_y;
+    int32_t pos_x, pos_y;
+    int32_t vel_x, vel_y;
+    int32_t score;
+    char key;                               // * Last key pressed, '-' if none
+    char reserved[3];
+    telemetry_stage_t stages[TELEMETRY_MAX_STAGES];
+} telemetry_t;
+
+typedef struct {
+    seqlock_t lock;
+    telemetry_t data;
+} telemetry_shm_t;
+
+int telemetry_shm_create(void);
+telemetry_shm_t *telemetry_shm_open(int writable);
+void telemetry_shm_close(telemetry_shm_t *page);
+void telemetry_shm_unlink(void);
+void telemetry_shm_publish(telemetry_shm_t *page, const telemetry_t *data);
+void telemetry_shm_read(const telemetry_shm_t *page, telemetry_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // TELEMETRY_SHM_H
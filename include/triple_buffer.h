@@ -0,0 +1,55 @@
+//
+// Created by Gian Marco Balia
+//
+// triple_buffer.h
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <stdint.h>
+
+/*
+ * Lock-free handoff of the newest value from one writer thread to one reader thread.
+ * The writer fills back() and publishes it; the reader calls update() and, if it returns true, front() is
+ * the newest value published. Three slots are swapped through an atomic index, so neither side ever waits
+ * or sees a value being written, and values published between two updates are skipped.
+ * The slots are reused: a value with owned storage (vectors) stops allocating once it reached its size.
+ */
+template <typename T>
+class TripleBuffer {
+private:
+    static constexpr uint8_t FRESH = 0x4;   // * The middle slot holds a value not taken by the reader yet
+    static constexpr uint8_t INDEX = 0x3;
+
+    T slots_[3];
+    std::atomic<uint8_t> middle_;           // * Slot between writer and reader, with the FRESH bit
+    uint8_t back_;                          // * Slot of the writer
+    uint8_t front_;                         // * Slot of the reader
+
+public:
+    TripleBuffer() : middle_(1), back_(0), front_(2) { }
+
+    T &back() {
+        // * Writer: slot to fill
+        return slots_[back_];
+    }
+
+    void publish() {
+        // * Writer: hand the filled slot to the reader, take the old middle one for the next value
+        back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    bool update() {
+        // * Reader: take the newest value, if one was published since the last update
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH)) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T &front() const {
+        // * Reader: newest value taken
+        return slots_[front_];
+    }
+};
+
+#endif                                      // TRIPLE_BUFFER_H
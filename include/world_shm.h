@@ -0,0 +1,37 @@
+//
+// Created by Gian Marco Balia
+//
+// world_shm.h
+#ifndef WORLD_SHM_H
+#define WORLD_SHM_H
+
+#include <stdint.h>
+#include "macros.h"
+#include "bitgrid.h"
+#include "seqlock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * POSIX shared-memory segment holding the game grid, as obstacle and target bitsets (bitgrid.h).
+ * The Blackboard is the only writer and publishes the grid only when it changes; Dynamics reads it in place.
+ * The seqlock sequence doubles as the generation of the grid: it is even when stable and grows at every update.
+ */
+typedef struct {
+    seqlock_t lock;
+    bitgrid_t cells;
+} world_shm_t;
+
+int world_shm_create(void);
+world_shm_t *world_shm_open(int writable);
+void world_shm_close(world_shm_t *world);
+void world_shm_unlink(void);
+void world_shm_publish(world_shm_t *world, const bitgrid_t *cells);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                      // WORLD_SHM_H
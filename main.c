@@ -10,6 +10,8 @@
 #include <sys/wait.h>
 #include <signal.h>
 #include "macros.h"
+#include "telemetry_shm.h"
+#include "world_shm.h"
 
 FILE *logfile;
 
@@ -48,6 +50,17 @@ int main(void) {
         close(pipe_blackboard[1]);
     }
 
+    // * Create the shared grid between Blackboard and Dynamics
+    if (world_shm_create() == -1) {
+        fprintf(stderr, "Failed to create the shared world.\n");
+        exit(EXIT_FAILURE);
+    }
+    // * Create the status page written by the Blackboard and read by the Inspector
+    if (telemetry_shm_create() == -1) {
+        fprintf(stderr, "Failed to create the telemetry page.\n");
+        exit(EXIT_FAILURE);
+    }
+
     // * Step 2: Create processes that use pipes
     if (create_processes(pipes, pipe_blackboard, pids, logfile_fd) == -1) {
         fprintf(stderr, "Failed to create processes.\n");
@@ -125,6 +138,8 @@ int main(void) {
     if (waitpid(watchdog_pid, NULL, 0) == -1) {
         perror("waitpid watchdog");
     }
+    world_shm_unlink();
+    telemetry_shm_unlink();
 
     return 0;
 }
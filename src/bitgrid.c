@@ -0,0 +1,34 @@
+//
+// Created by Gian Marco Balia
+//
+// src/bitgrid.c
+#include <string.h>
+#include "bitgrid.h"
+
+void bitgrid_clear(bitgrid_t *cells) {
+    /*
+     * Empty every cell.
+    */
+    memset(cells, 0, sizeof(bitgrid_t));
+}
+
+void bitgrid_from_chars(bitgrid_t *cells, const char grid[GAME_HEIGHT][GAME_WIDTH]) {
+    /*
+     * Build the bitsets of a char grid: 'o' is an obstacle, '0'-'9' a target, anything else is empty.
+     * @param cells The bitsets to fill.
+     * @param grid The char grid.
+    */
+    const char *flat = &grid[0][0];
+    for (int word = 0; word < BITGRID_WORDS; word++) {
+        uint64_t obstacles = 0, targets = 0;
+        const int first = word * 64;
+        const int last = first + 64 < BITGRID_CELLS ? first + 64 : BITGRID_CELLS;
+        for (int index = first; index < last; index++) {
+            const unsigned char cell_class = BITGRID_CELL_CLASS(flat[index]);
+            obstacles |= (uint64_t)(cell_class == CELL_OBSTACLE) << (index - first);
+            targets |= (uint64_t)(cell_class == CELL_TARGET) << (index - first);
+        }
+        cells->obstacles[word] = obstacles;
+        cells->targets[word] = targets;
+    }
+}
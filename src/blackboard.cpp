@@ -4,6 +4,7 @@
 // src/blackboard.cpp
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <unistd.h>
 #include <string.h>
 #include <signal.h>
@@ -20,7 +21,21 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <map>
+#include <mutex>
 #include "macros.h"
+#include "dds_qos.h"
+#include "dds_transport.h"
+#include "dronesim.h"
+#include "event_loop.h"
+#include "frame_protocol.h"
+#include "grid_renderer.h"
+#include "latency_histogram.h"
+#include "map_codec.h"
+#include "map_layer.h"
+#include "telemetry_shm.h"
+#include "triple_buffer.h"
+#include "world_shm.h"
 
 #include <fastdds/dds/domain/DomainParticipant.hpp>
 #include <fastdds/dds/domain/DomainParticipantFactory.hpp>
@@ -29,11 +44,11 @@
 #include <fastdds/dds/subscriber/Subscriber.hpp>
 #include <fastdds/dds/subscriber/qos/DataReaderQos.hpp>
 #include <fastdds/dds/subscriber/SampleInfo.hpp>
+#include <fastdds/dds/core/LoanableSequence.hpp>
 #include <fastdds/dds/topic/TypeSupport.hpp>
-#include <fastdds/rtps/transport/shared_mem/SharedMemTransportDescriptor.hpp>
-#include <fastdds/rtps/transport/TCPv4TransportDescriptor.hpp>
-#include <fastdds/utils/IPLocator.hpp>
 
+#include "MapItemPubSubTypes.hpp"
+#include "MapLayerPubSubTypes.hpp"
 #include "ObstaclesPubSubTypes.hpp"
 #include "TargetsPubSubTypes.hpp"
 
@@ -46,15 +61,34 @@ FILE *logfile;
 int parser(int argc, char *argv[], int *read_fds, int *write_fds);
 void signal_triggered(int signum);
 int initialize_ncurses();
-void command_drone(int *drone_force, char c);
 pid_t launch_inspection_window();
-void remove_target_on_path(char grid[GAME_HEIGHT][GAME_WIDTH], int x0, int y0, int x1, int y1);
+void dump_stats(FILE *out, const latency_histogram_t *stages);
+void log_startup(const char *event, uint64_t start);
+
+// * Stages of a frame whose latency is measured
+enum {
+    STAGE_FRAME,                            // * Work of a whole frame tick
+    STAGE_KEYBOARD,                         // * Read of the keyboard pipe
+    STAGE_DRAW,                             // * Grid redraw in the window
+    STAGE_DYNAMICS,                         // * From a state sent to dynamics to its reply
+    STAGE_APPLY_MOVE,                       // * Targets removed on the path and score
+    STAGE_TELEMETRY,                        // * Status page update
+    STAGE_REFRESH,                          // * wrefresh
+    NUM_STAGES
+};
+static const char *stage_names[NUM_STAGES] = {
+    "frame", "keyboard", "draw", "dynamics", "apply_move", "telemetry", "refresh"
+};
 
 class ObstaclesListener : public DataReaderListener {
+private:
+    Obstacles obstacles_msg_;               // * Only used by the DDS thread
+    uint64_t samples_ = 0;
+
 public:
-    std::atomic_int samples_;
-    Obstacles obstacles_msg_;
-    ObstaclesListener() : samples_(0) {}
+    TripleBuffer<MapLayerSample> layer_;    // * Newest obstacles, handed to the game loop
+    int notify_fd_;                         // * Event loop woken at every sample, -1 for none
+    ObstaclesListener() : notify_fd_(-1) {}
     ~ObstaclesListener() override {}
 
     void on_subscription_matched(DataReader* reader, const SubscriptionMatchedStatus &info) override
@@ -71,20 +105,17 @@ public:
 
     void on_data_available(DataReader* reader) override {
         SampleInfo info;
-        if (reader->take_next_sample(&obstacles_msg_, &info) == RETCODE_OK)
+        while (reader->take_next_sample(&obstacles_msg_, &info) == RETCODE_OK)
         {
             if (info.valid_data)
             {
-                samples_++;
-                /*std::cout << "Obstacles Sample #" << samples_ << ": "
-                          << "Number of obstacles: " << obstacles_msg_.obstacles_number() << std::endl;
-                const auto & xs = obstacles_msg_.obstacles_x();
-                const auto & ys = obstacles_msg_.obstacles_y();
-                for (size_t i = 0; i < xs.size(); i++)
-                {
-                    std::cout << "  (" << xs[i] << ", " << ys[i] << ")";
-                }
-                std::cout << std::endl;*/
+                // * Copy the sample in the free slot and hand it over, without waiting for the game loop
+                MapLayerSample &layer = layer_.back();
+                layer.x.assign(obstacles_msg_.obstacles_x().begin(), obstacles_msg_.obstacles_x().end());
+                layer.y.assign(obstacles_msg_.obstacles_y().begin(), obstacles_msg_.obstacles_y().end());
+                layer.sequence = ++samples_;
+                layer_.publish();
+                if (notify_fd_ != -1) event_loop_notify(notify_fd_);
             }
         }
     }
@@ -92,11 +123,15 @@ public:
 
 class TargetsListener : public DataReaderListener
 {
+private:
+    Targets targets_msg_;                   // * Only used by the DDS thread
+    uint64_t samples_ = 0;
+
 public:
-    std::atomic_int samples_;
-    Targets targets_msg_;
+    TripleBuffer<MapLayerSample> layer_;    // * Newest targets, handed to the game loop
+    int notify_fd_;                         // * Event loop woken at every sample, -1 for none
 
-    TargetsListener() : samples_(0) { }
+    TargetsListener() : notify_fd_(-1) { }
     ~TargetsListener() override { }
 
     void on_subscription_matched(DataReader* reader, const SubscriptionMatchedStatus &info) override {
@@ -113,29 +148,168 @@ public:
     void on_data_available(DataReader* reader) override
     {
         SampleInfo info;
-        if (reader->take_next_sample(&targets_msg_, &info) == RETCODE_OK)
+        while (reader->take_next_sample(&targets_msg_, &info) == RETCODE_OK)
         {
             if (info.valid_data)
             {
-                samples_++;
-                /*std::cout << "Targets Sample #" << samples_ << ": "
-                           << "Number of targets: " << targets_msg_.targets_number() << std::endl;
-                const auto & xs = targets_msg_.targets_x();
-                const auto & ys = targets_msg_.targets_y();
-                for (size_t i = 0; i < xs.size(); i++)
+                // * Copy the sample in the free slot and hand it over, without waiting for the game loop
+                MapLayerSample &layer = layer_.back();
+                layer.x.assign(targets_msg_.targets_x().begin(), targets_msg_.targets_x().end());
+                layer.y.assign(targets_msg_.targets_y().begin(), targets_msg_.targets_y().end());
+                layer.sequence = ++samples_;
+                layer_.publish();
+                if (notify_fd_ != -1) event_loop_notify(notify_fd_);
+            }
+        }
+    }
+};
+
+class MapLayerListener : public DataReaderListener
+{
+private:
+    MapLayer layer_msg_;                    // * Only used by the DDS thread
+    uint64_t samples_ = 0;
+
+public:
+    TripleBuffer<MapLayerSample> layer_;    // * Newest layer (obstacles or targets), handed to the game loop
+    int notify_fd_;                         // * Event loop woken at every sample, -1 for none
+
+    MapLayerListener() : notify_fd_(-1) { }
+    ~MapLayerListener() override { }
+
+    void on_data_available(DataReader* reader) override
+    {
+        SampleInfo info;
+        while (reader->take_next_sample(&layer_msg_, &info) == RETCODE_OK)
+        {
+            if (!info.valid_data || layer_msg_.version() != MAP_CODEC_VERSION)
+            {
+                continue;
+            }
+            // * Decode the sample in the free slot and hand it over, without waiting for the game loop
+            const int count = static_cast<int>(std::min<uint32_t>(layer_msg_.count(), MAP_CODEC_MAX_CELLS));
+            MapLayerSample &layer = layer_.back();
+            layer.x.resize(count);
+            layer.y.resize(count);
+            if (map_codec_decode(layer_msg_.encoding(), layer_msg_.payload().data(), layer_msg_.payload().size(),
+                    layer_msg_.width(), layer_msg_.height(), static_cast<int>(layer_msg_.count()),
+                    layer.x.data(), layer.y.data()) == -1)
+            {
+                // * Malformed: the slot is overwritten by the next sample
+                continue;
+            }
+            layer.sequence = ++samples_;
+            layer_.publish();
+            if (notify_fd_ != -1) event_loop_notify(notify_fd_);
+        }
+    }
+};
+
+class MapLayerPlainListener : public DataReaderListener
+{
+private:
+    LoanableSequence<MapLayerPlain> samples_msg_;  // * Loaned from the shared segment, only used by the DDS thread
+    SampleInfoSeq infos_;
+    uint64_t samples_ = 0;
+
+public:
+    TripleBuffer<MapLayerSample> layer_;    // * Newest layer (obstacles or targets), handed to the game loop
+    int notify_fd_;                         // * Event loop woken at every sample, -1 for none
+
+    MapLayerPlainListener() : notify_fd_(-1) { }
+    ~MapLayerPlainListener() override { }
+
+    void on_data_available(DataReader* reader) override
+    {
+        // * The samples are decoded where the writer encoded them (data-sharing), then the loan is returned
+        while (reader->take(samples_msg_, infos_) == RETCODE_OK)
+        {
+            bool published = false;
+            for (int32_t i = 0; i < infos_.length(); i++)
+            {
+                const MapLayerPlain &sample = samples_msg_[i];
+                if (!infos_[i].valid_data || sample.version() != MAP_CODEC_VERSION ||
+                    sample.size() > sample.payload().size())
+                {
+                    continue;
+                }
+                const int count = static_cast<int>(std::min<uint32_t>(sample.count(), MAP_CODEC_MAX_CELLS));
+                MapLayerSample &layer = layer_.back();
+                layer.x.resize(count);
+                layer.y.resize(count);
+                if (map_codec_decode(sample.encoding(), sample.payload().data(), sample.size(), sample.width(),
+                        sample.height(), static_cast<int>(sample.count()), layer.x.data(), layer.y.data()) == -1)
                 {
-                     std::cout << "  (" << xs[i] << ", " << ys[i] << ")";
+                    continue;
                 }
-                std::cout << std::endl;*/
+                layer.sequence = ++samples_;
+                layer_.publish();
+                published = true;
             }
+            reader->return_loan(samples_msg_, infos_);
+            if (published && notify_fd_ != -1) event_loop_notify(notify_fd_);
         }
     }
 };
 
+class MapItemListener : public DataReaderListener
+{
+private:
+    MapItem item_msg_;                      // * Only used by the DDS thread
+    std::map<InstanceHandle_t, MapItemDelta> alive_;  // * Cell of every instance alive, only used by the DDS thread
+    std::vector<MapItemDelta> batch_;       // * Only used by the DDS thread
+    std::mutex mutex_;
+    std::vector<MapItemDelta> pending_;     // * Deltas not taken by the game loop yet, guarded by mutex_
+
+public:
+    int notify_fd_;                         // * Event loop woken at every batch of deltas, -1 for none
+
+    MapItemListener() : notify_fd_(-1) { }
+    ~MapItemListener() override { }
+
+    void on_data_available(DataReader* reader) override
+    {
+        SampleInfo info;
+        while (reader->take_next_sample(&item_msg_, &info) == RETCODE_OK)
+        {
+            if (info.instance_state == ALIVE_INSTANCE_STATE)
+            {
+                if (!info.valid_data) continue;
+                const MapItemDelta delta = {item_msg_.x(), item_msg_.y(), item_msg_.width(), item_msg_.height(), true};
+                alive_[info.instance_handle] = delta;
+                batch_.push_back(delta);
+            }
+            else
+            {
+                // * Disposed, or its writer is gone: only the instance is known, its cell was kept when it was written
+                auto item = alive_.find(info.instance_handle);
+                if (item == alive_.end()) continue;
+                item->second.alive = false;
+                batch_.push_back(item->second);
+                alive_.erase(item);
+            }
+        }
+        if (batch_.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.insert(pending_.end(), batch_.begin(), batch_.end());
+        }
+        batch_.clear();
+        if (notify_fd_ != -1) event_loop_notify(notify_fd_);
+    }
+
+    void take(std::vector<MapItemDelta> &deltas) {
+        // * Game loop: move out the deltas received since the last take (deltas must be empty)
+        std::lock_guard<std::mutex> lock(mutex_);
+        deltas.swap(pending_);
+    }
+};
+
 class CustomTransportSubscriber {
 private:
-    DomainParticipant *participant_obstacles, *participant_targets;
-    Subscriber *subscriber_obstacles, *subscriber_targets;
+    // * A single participant, client of both discovery servers, and a single subscriber for all the readers
+    DomainParticipant *participant_;
+    Subscriber *subscriber_;
 
     // * Topics and DataReaders for Obstacles e Targets
     Topic *obstacles_topic_;
@@ -143,171 +317,313 @@ private:
     Topic *targets_topic_;
     DataReader *targets_reader_;
 
-    // * TypeSupport two types
+    // * TypeSupport of the legacy types and of the compact one
     TypeSupport obstacles_type_;
     TypeSupport targets_type_;
+    TypeSupport layer_type_;
+    TypeSupport item_type_;
+    TypeSupport plain_type_;
 
+    // * Item, compact or legacy listeners, as chosen by MAP_FORMAT_ENV (the first one published, in this order)
     ObstaclesListener obstacles_listener_;
     TargetsListener targets_listener_;
+    MapLayerListener obstacles_layer_listener_;
+    MapLayerListener targets_layer_listener_;
+    MapLayerPlainListener obstacles_plain_listener_;
+    MapLayerPlainListener targets_plain_listener_;
+    MapItemListener obstacles_item_listener_;
+    MapItemListener targets_item_listener_;
+    TripleBuffer<MapLayerSample> *obstacles_layer_;
+    TripleBuffer<MapLayerSample> *targets_layer_;
+    bool items_;                            // * The map comes as MapItem deltas, applied to the grid in place
+    std::vector<MapItemDelta> deltas_;
+    std::vector<char> free_digits_;         // * Digits not shown by any target, for the targets that appear
+
+    // * Layers of the map currently in the grid, to skip samples that repeat it
+    MapLayerSample shown_obstacles_, shown_targets_;
+    bool shown_;
+    std::mt19937 random_;
 
 public:
     CustomTransportSubscriber()
-        : participant_obstacles(nullptr)
-        , participant_targets(nullptr)
-        , subscriber_obstacles(nullptr)
-        , subscriber_targets(nullptr)
+        : participant_(nullptr)
+        , subscriber_(nullptr)
         , obstacles_topic_(nullptr)
         , obstacles_reader_(nullptr)
         , targets_topic_(nullptr)
         , targets_reader_(nullptr)
         , obstacles_type_(new ObstaclesPubSubType())
         , targets_type_(new TargetsPubSubType())
-    { }
+        , layer_type_(new MapLayerPubSubType())
+        , item_type_(new MapItemPubSubType())
+        , plain_type_(new MapLayerPlainPubSubType())
+        , obstacles_layer_(nullptr)
+        , targets_layer_(nullptr)
+        , items_(false)
+        , shown_(false)
+        , random_(std::random_device{}())
+    {
+        free_digits_ = {'0','1','2','3','4','5','6','7','8','9'};
+        std::shuffle(free_digits_.begin(), free_digits_.end(), random_);
+    }
 
     virtual ~CustomTransportSubscriber()
     {
         if (obstacles_reader_ != nullptr)
         {
-            subscriber_obstacles->delete_datareader(obstacles_reader_);
+            subscriber_->delete_datareader(obstacles_reader_);
         }
         if (targets_reader_ != nullptr)
         {
-            subscriber_targets->delete_datareader(targets_reader_);
+            subscriber_->delete_datareader(targets_reader_);
         }
         if (obstacles_topic_ != nullptr)
         {
-            participant_obstacles->delete_topic(obstacles_topic_);
+            participant_->delete_topic(obstacles_topic_);
         }
         if (targets_topic_ != nullptr)
         {
-            participant_targets->delete_topic(targets_topic_);
+            participant_->delete_topic(targets_topic_);
         }
-        if (subscriber_obstacles != nullptr)
+        if (subscriber_ != nullptr)
         {
-            participant_obstacles->delete_subscriber(subscriber_obstacles);
+            participant_->delete_subscriber(subscriber_);
         }
-        if (subscriber_targets != nullptr)
-        {
-            participant_targets->delete_subscriber(subscriber_targets);
-        }
-        DomainParticipantFactory::get_instance()->delete_participant(participant_obstacles);
-        DomainParticipantFactory::get_instance()->delete_participant(participant_targets);
-    }
-
-    bool init() {
-        DomainParticipantQos participantQos_obstacles = PARTICIPANT_QOS_DEFAULT;
-        DomainParticipantQos participantQos_targets = PARTICIPANT_QOS_DEFAULT;
-
-        // * Configure the current participant as SERVER
-        participantQos_obstacles.wire_protocol().builtin.discovery_config.discoveryProtocol = DiscoveryProtocol::CLIENT;
-        participantQos_targets.wire_protocol().builtin.discovery_config.discoveryProtocol = DiscoveryProtocol::CLIENT;
-
-        //participantQos_obstacles.name("Obstacles_Subscriber");
-        //participantQos_targets.name("Targets_Subscriber");
-
-        // *Add custom user transport with TCP port 0 (automatic port assignation)
-        auto data_transport_obstacles = std::make_shared<TCPv4TransportDescriptor>();
-        data_transport_obstacles->add_listener_port(0);
-        participantQos_obstacles.transport().user_transports.push_back(data_transport_obstacles);
-        auto data_transport_targets = std::make_shared<TCPv4TransportDescriptor>();
-        data_transport_targets->add_listener_port(0);
-        participantQos_targets.transport().user_transports.push_back(data_transport_targets);
-
-        // * Define the Obstacles server locator to be on interface IPV4_OBSTACLES and port SERVER_PORT_OBSTACLES
-        constexpr uint16_t server_port_obstacles = SERVER_PORT_OBSTACLES;
-        Locator_t server_locator_obstacles;
-        IPLocator::setIPv4(server_locator_obstacles, IPV4_OBSTACLES_CLIENT);
-        IPLocator::setPhysicalPort(server_locator_obstacles, server_port_obstacles);
-        IPLocator::setLogicalPort(server_locator_obstacles, server_port_obstacles);
-
-        // * Add the Obstacles Server
-        participantQos_obstacles.wire_protocol().builtin.discovery_config.m_DiscoveryServers.push_back(server_locator_obstacles);
-
-        // * Define the Targets server locator to be on interface IPV4_TARGETS and port SERVER_PORT_TARGETS
-        constexpr uint16_t server_port_targets = SERVER_PORT_TARGETS;
-        Locator_t server_locator_targets;
-        IPLocator::setIPv4(server_locator_targets, IPV4_TARGETS_CLIENT);
-        IPLocator::setPhysicalPort(server_locator_targets, server_port_targets);
-        IPLocator::setLogicalPort(server_locator_targets, server_port_targets);
-
-        // * Add the Targets Server
-        participantQos_targets.wire_protocol().builtin.discovery_config.m_DiscoveryServers.push_back(server_locator_targets);
-
-        // * Create the DomainParticipants
-        participant_obstacles = DomainParticipantFactory::get_instance()->create_participant(0, participantQos_obstacles);
-        if (participant_obstacles == nullptr)
+        DomainParticipantFactory::get_instance()->delete_participant(participant_);
+    }
+
+    bool init(const int notify_fd) {
+        // * The listeners wake the event loop of the Blackboard when a map arrives
+        obstacles_listener_.notify_fd_ = notify_fd;
+        targets_listener_.notify_fd_ = notify_fd;
+        obstacles_layer_listener_.notify_fd_ = notify_fd;
+        targets_layer_listener_.notify_fd_ = notify_fd;
+        obstacles_item_listener_.notify_fd_ = notify_fd;
+        targets_item_listener_.notify_fd_ = notify_fd;
+        obstacles_plain_listener_.notify_fd_ = notify_fd;
+        targets_plain_listener_.notify_fd_ = notify_fd;
+        const int format = map_codec_format(MAP_FORMAT_READ_DEFAULT);
+        items_ = format & MAP_FORMAT_ITEMS;
+        const bool compact = !items_ && (format & MAP_FORMAT_COMPACT);
+        const int transport = dds_transport_mode();
+        const bool plain = compact && transport == DDS_TRANSPORT_SHM;
+        dds_qos_load(logfile);
+        DomainParticipantQos participantQos = PARTICIPANT_QOS_DEFAULT;
+        participantQos.name("Blackboard_Subscriber");
+
+        // * Configure the participant as CLIENT (TCP port assigned by the system) of both the Obstacles server
+        // * (IPV4_OBSTACLES_CLIENT:SERVER_PORT_OBSTACLES) and the Targets server: one transport, one set of
+        // * threads and sockets, one discovery for the two topics
+        dds_transport_client(participantQos, transport);
+        dds_transport_add_server(participantQos, transport, IPV4_OBSTACLES_CLIENT, SERVER_PORT_OBSTACLES);
+        dds_transport_add_server(participantQos, transport, IPV4_TARGETS_CLIENT, SERVER_PORT_TARGETS);
+
+        // * Create the DomainParticipant
+        participant_ = DomainParticipantFactory::get_instance()->create_participant(0, participantQos);
+        if (participant_ == nullptr)
         {
-            std::cerr << "Errore nella creazione del DomainParticipant Obstacles con configurazione TCP/Discovery" << std::endl;
+            std::cerr << "Errore nella creazione del DomainParticipant con configurazione TCP/Discovery" << std::endl;
             return false;
         }
-        participant_targets = DomainParticipantFactory::get_instance()->create_participant(0, participantQos_targets);
-        if (participant_targets == nullptr)
-        {
-            std::cerr << "Errore nella creazione del DomainParticipant Targets con configurazione TCP/Discovery" << std::endl;
-            return false;
+        // * Register the types of DDS and make the topics: the keyed MapItem type, the compact MapLayer type, or
+        // * the legacy ones
+        if (items_) {
+            item_type_.register_type(participant_, "MapItem");
+            obstacles_topic_ = participant_->create_topic(TOPIC_NAME_OBSTACLES_ITEMS, "MapItem", TOPIC_QOS_DEFAULT);
+            targets_topic_ = participant_->create_topic(TOPIC_NAME_TARGETS_ITEMS, "MapItem", TOPIC_QOS_DEFAULT);
+        } else if (plain) {
+            plain_type_.register_type(participant_, "MapLayerPlain");
+            obstacles_topic_ = participant_->create_topic(TOPIC_NAME_OBSTACLES_PLAIN, "MapLayerPlain",
+                TOPIC_QOS_DEFAULT);
+            targets_topic_ = participant_->create_topic(TOPIC_NAME_TARGETS_PLAIN, "MapLayerPlain", TOPIC_QOS_DEFAULT);
+        } else if (compact) {
+            layer_type_.register_type(participant_, "MapLayer");
+            obstacles_topic_ = participant_->create_topic(TOPIC_NAME_OBSTACLES_LAYER, "MapLayer", TOPIC_QOS_DEFAULT);
+            targets_topic_ = participant_->create_topic(TOPIC_NAME_TARGETS_LAYER, "MapLayer", TOPIC_QOS_DEFAULT);
+        } else {
+            obstacles_type_.register_type(participant_, "Obstacles");
+            targets_type_.register_type(participant_, "Targets");
+            obstacles_topic_ = participant_->create_topic(TOPIC_NAME_OBSTACLES, "Obstacles", TOPIC_QOS_DEFAULT);
+            targets_topic_ = participant_->create_topic(TOPIC_NAME_TARGETS, "Targets", TOPIC_QOS_DEFAULT);
         }
-        // * Register the two types of DDS
-        obstacles_type_.register_type(participant_obstacles, "Obstacles");
-        targets_type_.register_type(participant_targets, "Targets");
-        // * Make topics TOPIC_NAME_OBSTACLES and TOPIC_NAME_TARGETS
-        obstacles_topic_ = participant_obstacles->create_topic(TOPIC_NAME_OBSTACLES, "Obstacles", TOPIC_QOS_DEFAULT);
-        if (obstacles_topic_ == nullptr) {
+        if (obstacles_topic_ == nullptr || targets_topic_ == nullptr) {
             return false;
         }
-        targets_topic_ = participant_targets->create_topic(TOPIC_NAME_TARGETS, "Targets", TOPIC_QOS_DEFAULT);
-        if (targets_topic_ == nullptr) {
+        // * Make the Subscriber of both topics
+        subscriber_ = participant_->create_subscriber(SUBSCRIBER_QOS_DEFAULT, nullptr);
+        if (subscriber_ == nullptr) {
             return false;
         }
-        // * Make the Obstacles Subscriber
-        subscriber_obstacles = participant_obstacles->create_subscriber(SUBSCRIBER_QOS_DEFAULT, nullptr);
-        if (subscriber_obstacles == nullptr) {
+
+        // * Make DataReaders for Obstacles and Targets: durable, so the last map comes as soon as they are matched
+        // * (or as set by the profiles of QOS_FILE_ENV)
+        const int instances = items_ ? BITGRID_CELLS : 1;
+        DataReaderQos reader_qos;
+        DataReaderListener *obstacles_listener = &obstacles_listener_;
+        DataReaderListener *targets_listener = &targets_listener_;
+        obstacles_layer_ = &obstacles_listener_.layer_;
+        targets_layer_ = &targets_listener_.layer_;
+        if (compact) {
+            obstacles_listener = &obstacles_layer_listener_;
+            targets_listener = &targets_layer_listener_;
+            obstacles_layer_ = &obstacles_layer_listener_.layer_;
+            targets_layer_ = &targets_layer_listener_.layer_;
+        }
+        if (plain) {
+            obstacles_listener = &obstacles_plain_listener_;
+            targets_listener = &targets_plain_listener_;
+            obstacles_layer_ = &obstacles_plain_listener_.layer_;
+            targets_layer_ = &targets_plain_listener_.layer_;
+        }
+        if (items_) {
+            // * An instance per cell: a lost dispose would leave a cell on the map, the readers must be reliable
+            obstacles_listener = &obstacles_item_listener_;
+            targets_listener = &targets_item_listener_;
+        }
+        dds_qos_reader(subscriber_, obstacles_topic_, instances, reader_qos);
+        dds_transport_data_sharing(reader_qos, transport);
+        obstacles_reader_ = subscriber_->create_datareader(obstacles_topic_, reader_qos, obstacles_listener);
+        if (obstacles_reader_ == nullptr) {
             return false;
         }
-        // * Make the Targets Subscriber
-        subscriber_targets = participant_targets->create_subscriber(SUBSCRIBER_QOS_DEFAULT, nullptr);
-        if (subscriber_targets == nullptr) {
+        dds_qos_reader(subscriber_, targets_topic_, instances, reader_qos);
+        dds_transport_data_sharing(reader_qos, transport);
+        targets_reader_ = subscriber_->create_datareader(targets_topic_, reader_qos, targets_listener);
+        if (targets_reader_ == nullptr) {
             return false;
         }
+        return true;
+    }
 
-        // * Make DataReaders for Obstacles and Targets
-        obstacles_reader_ = subscriber_obstacles->create_datareader(obstacles_topic_, DATAREADER_QOS_DEFAULT, &obstacles_listener_);
-        if (obstacles_reader_ == nullptr) {
+    bool update(char grid[GAME_HEIGHT][GAME_WIDTH], dronesim_state_t *game, bool *game_changed) {
+        /*
+         * Take the newest obstacles and targets handed over by the listeners and rebuild the grid with them.
+         * @param grid The grid of the next game, rewritten only if the map changed.
+         * @param game The running game, which gets the new obstacles at once (dronesim_load_map), nullptr if none.
+         * @param game_changed Set to true if the cells of the game changed.
+         * @return true if the grid was rewritten.
+        */
+        if (items_) {
+            return apply_items(grid, game, game_changed);
+        }
+        const bool new_obstacles = obstacles_layer_->update();
+        const bool new_targets = targets_layer_->update();
+        if (!new_obstacles && !new_targets) {
             return false;
         }
-        targets_reader_ = subscriber_targets->create_datareader(targets_topic_, DATAREADER_QOS_DEFAULT, &targets_listener_);
-        if (targets_reader_ == nullptr) {
+        const MapLayerSample &obstacles = obstacles_layer_->front();
+        const MapLayerSample &targets = targets_layer_->front();
+        // * Both layers are needed, and a sample repeating the current map changes nothing
+        if (obstacles.sequence == 0 || targets.sequence == 0) {
             return false;
         }
+        if (shown_ && obstacles.same_cells(shown_obstacles_) && targets.same_cells(shown_targets_)) {
+            return false;
+        }
+        shown_obstacles_.x = obstacles.x;
+        shown_obstacles_.y = obstacles.y;
+        shown_targets_.x = targets.x;
+        shown_targets_.y = targets.y;
+        shown_ = true;
+        memset(grid, ' ', GAME_HEIGHT * GAME_WIDTH);
+        fill(grid, obstacles, targets);
+        if (game != nullptr && dronesim_load_map(game, grid) > 0) {
+            *game_changed = true;
+        }
         return true;
     }
 
-    void run(char grid[GAME_HEIGHT][GAME_WIDTH]) {
-        while (obstacles_listener_.samples_ == 0||targets_listener_.samples_ == 0){
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    bool apply_items(char grid[GAME_HEIGHT][GAME_WIDTH], dronesim_state_t *game, bool *game_changed) {
+        /*
+         * Apply the cells written and disposed on the MapItem topics since the last call to the grid and,
+         * cell by cell, to the running game: the cost follows the changes, not the size of the map. A target
+         * that appears takes a digit not shown; in a running game only the obstacles change (dronesim_load_map).
+         * @param grid The grid of the next game, changed in place.
+         * @param game The running game, nullptr if none: its counts are kept by dronesim_set_obstacle and its
+         * force field is updated around the changed cells only.
+         * @param game_changed Set to true if the cells of the game changed.
+         * @return true if any cell of the grid changed.
+        */
+        bool changed = false;
+        int game_cells = 0;
+        obstacles_item_listener_.take(deltas_);
+        for (const MapItemDelta &delta : deltas_) {
+            int col, row;
+            item_cell(delta, &col, &row);
+            char &cell = grid[row][col];
+            if (delta.alive) {
+                if (cell >= '0' && cell <= '9') free_digits_.push_back(cell);
+                cell = 'o';
+            } else if (cell == 'o') {
+                cell = ' ';
+            }
+            if (game != nullptr) {
+                game_cells += dronesim_set_obstacle(game, col, row, delta.alive);
+            }
+            changed = true;
+        }
+        deltas_.clear();
+        targets_item_listener_.take(deltas_);
+        for (const MapItemDelta &delta : deltas_) {
+            int col, row;
+            item_cell(delta, &col, &row);
+            char &cell = grid[row][col];
+            if (delta.alive) {
+                if (cell == ' ' && !free_digits_.empty()) {
+                    cell = free_digits_.back();
+                    free_digits_.pop_back();
+                }
+            } else if (cell >= '0' && cell <= '9') {
+                free_digits_.push_back(cell);
+                cell = ' ';
+            }
+            changed = true;
+        }
+        deltas_.clear();
+        if (game_cells > 0) {
+            force_field_update(&game->field, &game->cells);
+            *game_changed = true;
         }
+        return changed;
+    }
+
+    static void item_cell(const MapItemDelta &delta, int *col, int *row) {
+        // * Cell of the grid of an item, scaled from the map of its publisher
+        const int width = delta.width > 0 ? delta.width : GAME_WIDTH;
+        const int height = delta.height > 0 ? delta.height : GAME_HEIGHT;
+        *col = std::clamp(static_cast<int>(static_cast<int64_t>(delta.x) * GAME_WIDTH / width), 0, GAME_WIDTH - 1);
+        *row = std::clamp(static_cast<int>(static_cast<int64_t>(delta.y) * GAME_HEIGHT / height), 0, GAME_HEIGHT - 1);
+    }
+
+    void fill(char grid[GAME_HEIGHT][GAME_WIDTH], const MapLayerSample &obstacles, const MapLayerSample &targets) {
         // * Obtain the vectors of the obstacles' coordinates
-        std::vector<int> obs_x = obstacles_listener_.obstacles_msg_.obstacles_x();
-        std::vector<int> obs_y = obstacles_listener_.obstacles_msg_.obstacles_y();
-        // * Compute the min and max for x and y
-        int min_obs_x = *std::min_element(obs_x.begin(), obs_x.end());
-        int max_obs_x = *std::max_element(obs_x.begin(), obs_x.end());
-        int min_obs_y = *std::min_element(obs_y.begin(), obs_y.end());
-        int max_obs_y = *std::max_element(obs_y.begin(), obs_y.end());
-        // * Compute the range (without zero)
-        int range_obs_x = (max_obs_x - min_obs_x) > 0 ? (max_obs_x - min_obs_x) : 1;
-        int range_obs_y = (max_obs_y - min_obs_y) > 0 ? (max_obs_y - min_obs_y) : 1;
-        // * Fill the grid with the scaled values
-        for (size_t i = 0; i < obs_x.size(); i++) {
-            int new_x = (GAME_WIDTH * (obs_x[i] - min_obs_x)) / range_obs_x;
-            int new_y = (GAME_HEIGHT * (obs_y[i] - min_obs_y)) / range_obs_y;
-            // * Clamp of the values to be sure that are valids
-            new_x = std::clamp(new_x, 0, GAME_WIDTH - 1);
-            new_y = std::clamp(new_y, 0, GAME_HEIGHT - 1);
-            grid[new_y][new_x] = 'o';
+        const std::vector<int32_t> &obs_x = obstacles.x;
+        const std::vector<int32_t> &obs_y = obstacles.y;
+        if (!obs_x.empty() && obs_x.size() == obs_y.size()) {
+            // * Compute the min and max for x and y
+            int min_obs_x = *std::min_element(obs_x.begin(), obs_x.end());
+            int max_obs_x = *std::max_element(obs_x.begin(), obs_x.end());
+            int min_obs_y = *std::min_element(obs_y.begin(), obs_y.end());
+            int max_obs_y = *std::max_element(obs_y.begin(), obs_y.end());
+            // * Compute the range (without zero)
+            int range_obs_x = (max_obs_x - min_obs_x) > 0 ? (max_obs_x - min_obs_x) : 1;
+            int range_obs_y = (max_obs_y - min_obs_y) > 0 ? (max_obs_y - min_obs_y) : 1;
+            // * Fill the grid with the scaled values
+            for (size_t i = 0; i < obs_x.size(); i++) {
+                int new_x = (GAME_WIDTH * (obs_x[i] - min_obs_x)) / range_obs_x;
+                int new_y = (GAME_HEIGHT * (obs_y[i] - min_obs_y)) / range_obs_y;
+                // * Clamp of the values to be sure that are valids
+                new_x = std::clamp(new_x, 0, GAME_WIDTH - 1);
+                new_y = std::clamp(new_y, 0, GAME_HEIGHT - 1);
+                grid[new_y][new_x] = 'o';
+            }
         }
         // * Obtain the vectors of the targets' coordinates
-        std::vector<int> trg_x = targets_listener_.targets_msg_.targets_x();
-        std::vector<int> trg_y = targets_listener_.targets_msg_.targets_y();
+        const std::vector<int32_t> &trg_x = targets.x;
+        const std::vector<int32_t> &trg_y = targets.y;
+        if (trg_x.empty() || trg_x.size() != trg_y.size()) {
+            return;
+        }
         // * Compute the min and max for x and y
         int min_trg_x = *std::min_element(trg_x.begin(), trg_x.end());
         int max_trg_x = *std::max_element(trg_x.begin(), trg_x.end());
@@ -319,9 +635,7 @@ public:
         // * Vector of values from '0' to '9'
         std::vector<char> digits = {'0','1','2','3','4','5','6','7','8','9'};
         // * Shuffle the vector to obtain randomness in the target numers
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(digits.begin(), digits.end(), g);
+        std::shuffle(digits.begin(), digits.end(), random_);
         size_t trg_count = trg_x.size();
         for (size_t i = 0; i < trg_count && i < digits.size(); i++) {
             int new_x = (GAME_WIDTH * (trg_x[i] - min_trg_x)) / range_trg_x;
@@ -359,8 +673,16 @@ int main(const int argc, char *argv[]) {
     const int keyboard = read_fds[0];
     const int dynamic_read = read_fds[1];
     const int dynamic_write = write_fds;
-    // * Make the named pipes with inspector process
-    mkfifo(INSPECTOR_FIFO, 0666);
+    // * Map the status page read by the inspector (created by the main process)
+    telemetry_shm_t *telemetry = telemetry_shm_open(1);
+    if (!telemetry) {
+        return EXIT_FAILURE;
+    }
+    // * Map the shared grid read by dynamics (created by the main process)
+    world_shm_t *world = world_shm_open(1);
+    if (!world) {
+        return EXIT_FAILURE;
+    }
     // * Initialise window's game
     if (initialize_ncurses() == EXIT_FAILURE) {
         fprintf(stderr, "Error initializing ncurses.\n");
@@ -383,208 +705,255 @@ int main(const int argc, char *argv[]) {
     // * Size of the grid game
     char grid[GAME_HEIGHT][GAME_WIDTH];
     memset(grid, ' ', sizeof(grid));
+    // * Event loop: frame tick, keyboard, replies of dynamics and notifications of the DDS subscriber
+    event_loop_t loop;
+    if (event_loop_open(&loop, FRAME_RATE) == -1) {
+        endwin();
+        return EXIT_FAILURE;
+    }
+    fcntl(keyboard, F_SETFL, fcntl(keyboard, F_GETFL) | O_NONBLOCK);
+    fcntl(dynamic_read, F_SETFL, fcntl(dynamic_read, F_GETFL) | O_NONBLOCK);
+    if (event_loop_add(&loop, keyboard, EPOLLIN) == -1 || event_loop_add(&loop, dynamic_read, EPOLLIN) == -1) {
+        perror("epoll_ctl");
+        endwin();
+        return EXIT_FAILURE;
+    }
+    // * A closed peer must not kill the Blackboard: failed writes are reported as errors
+    signal(SIGPIPE, SIG_IGN);
+    // * The maps arrive in the background for the whole game, the menu is shown until the first one
+    // * Time to the participant and to the first map, and resident memory, are written to the logfile
+    const uint64_t dds_start = latency_now();
     CustomTransportSubscriber *mysub = new CustomTransportSubscriber();
-    if (mysub->init())
-    {
-        mysub->run(grid);
+    bool map_ready = false;
+    if (!mysub->init(loop.notify_fd)) {
+        delete mysub;
+        mysub = nullptr;
+        map_ready = true;
+    }
+    else {
+        log_startup("participant ready", dds_start);
     }
-    delete mysub;
     // * Game status: 0=menu, 1=initialization, 2=running, -2=pause, -1=quit
     int status = 0;
-    int drone_pos[4] = {0, 0, 0, 0};
-    int drone_force[2] = {0, 0};
-    // * Score variables
-    int score = MAX_SCORE;
-    int distance_traveled = 0;
-    int count_obstacles = 0;
-    time_t start_time = time(NULL);
+    // * Game state (grid, drone, score), updated with the simulation core
+    static dronesim_state_t game;
+    dronesim_reset(&game, grid);
+    double *drone_pos = game.drone_pos;
+    int *drone_force = game.drone_force;
+    // * Sequence number of the last state sent to dynamics, and whether the shared grid must be updated
+    uint32_t sequence = 0;
+    bool map_changed = true;
+    // * Last state answered by dynamics, and physics steps and key of the states still in flight
+    uint32_t acked = 0;
+    int inflight_substeps[FRAME_PIPELINE_DEPTH] = {0};
+    char inflight_key[FRAME_PIPELINE_DEPTH] = {0};
+    uint64_t inflight_sent[FRAME_PIPELINE_DEPTH] = {0};
+    // * Flags of the next state: the first one of a game places the drone of dynamics
+    uint8_t state_flags = FRAME_FLAG_RESET;
+    // * Real-time clock of the physics: fixed steps, as many as the elapsed time requires
+    dronesim_clock_t physics_clock;
+    dronesim_clock_start(&physics_clock);
+    // * Map and drone on the window, redrawn only where they changed
+    GridRenderer renderer;
     // * Launches a new terminal window
     pid_t insp_pid = launch_inspection_window();
-    // * Char read from keyboard
-    char c;
-    fd_set read_keyboard;
-    timeval timeout;
-    do {
-        switch (status) {
-            case 0: { // * Menu
-                const char *message = "Press S to start or Q to quit";
-                int msg_length = (int)strlen(message);
-                mvwprintw(win, height / 2, (width - msg_length) / 2, "%s", message);
-                // * Attempt to read a character from the keyboard pipe (non-blocking)
-                FD_ZERO(&read_keyboard);
-                FD_SET(keyboard, &read_keyboard);
-                timeout.tv_sec = 0;
-                timeout.tv_usec = 1e6/FRAME_RATE; // * Frame rate of ~60Hz
-                if (select(keyboard + 1, &read_keyboard, NULL, NULL, &timeout) > 0) {
-                    if (FD_ISSET(keyboard, &read_keyboard)) {
-                        const ssize_t bytesRead = read(keyboard, &c, 1);
-                        if (bytesRead == -1) {
-                            perror("read keyboard");
-                            break;
-                        }
+    // * Latency of the stages of a frame, written to STATS_FILE every STATS_PERIOD and at exit
+    static latency_histogram_t stages[NUM_STAGES];
+    for (int i = 0; i < NUM_STAGES; i++) {
+        latency_init(&stages[i], stage_names[i]);
+    }
+    uint64_t next_stats = latency_now() + (uint64_t)(STATS_PERIOD * 1e9);
+    // * Status shown by the inspector, with the percentiles of the stages refreshed every second
+    static telemetry_t status_page;
+    for (int i = 0; i < NUM_STAGES && i < TELEMETRY_MAX_STAGES; i++) {
+        snprintf(status_page.stages[i].name, TELEMETRY_STAGE_NAME, "%s", stage_names[i]);
+    }
+    uint64_t next_percentiles = 0;
+    // * Keys received since the last frame, applied in order at the next one
+    char keys[64];
+    int num_keys = 0;
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    bool quit = false;
+    while (!quit) {
+        const int ready = event_loop_wait(&loop, events, EVENT_LOOP_MAX_EVENTS);
+        if (ready == -1) {
+            perror("epoll_wait");
+            break;
+        }
+        bool frame_due = false;
+        for (int i = 0; i < ready && !quit; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == loop.timer_fd) {
+                frame_due = event_loop_ticks(&loop) > 0;
+            }
+            else if (fd == loop.notify_fd) {
+                // * A map sample arrived: it is the map of the next game, and brings its obstacles into a running one
+                event_loop_notified(&loop);
+                bool game_changed = false;
+                if (mysub != nullptr && mysub->update(grid, status == 2 ? &game : nullptr, &game_changed)) {
+                    if (status == 2) {
+                        // * The targets left, the drone, the score and the time go on; the renderer draws only the
+                        // * differences
+                        if (game_changed) map_changed = true;
+                    }
+                    else if (!map_ready) {
+                        werase(win);
+                        renderer.invalidate();
                     }
+                    if (!map_ready) log_startup("first map", dds_start);
+                    map_ready = true;
                 }
-                else {
-                    c = '\0';
+            }
+            else if (fd == keyboard) {
+                // * Take every key available, without waiting
+                char buffer[sizeof(keys)];
+                const uint64_t start = latency_now();
+                const ssize_t bytes_read = read(keyboard, buffer, sizeof(buffer));
+                latency_record(&stages[STAGE_KEYBOARD], latency_now() - start);
+                if (bytes_read > 0) {
+                    for (ssize_t j = 0; j < bytes_read && num_keys < (int)sizeof(keys); j++) {
+                        keys[num_keys++] = buffer[j];
+                    }
                 }
-                // * Change the game status
-                if (c == 'q') status = -1;  // * Then quit
-                if (c == 's') {
-                    status = 1;  // * Run the game
-                    werase(win);  // * Erase entire window
+                else if (bytes_read == 0 || (errno != EAGAIN && errno != EINTR)) {
+                    if (bytes_read == -1) perror("read keyboard");
+                    event_loop_remove(&loop, keyboard);
                 }
-                break;
             }
-            case 1: { // * initialization
-                // * Clean possible dirties in the grid
-                for (int row = 0; row < GAME_HEIGHT; row++) {
-                    for (int col = 0; col < GAME_WIDTH; col++) {
-                        if (!strchr("o0123456789", grid[row][col])) {
-                            grid[row][col] = ' ';
-                        }
+            else if (fd == dynamic_read) {
+                // * Take every reply available, in order: each one moves the drone along its path
+                uint32_t reply_sequence;
+                frame_reply_t reply;
+                while (!quit) {
+                    if (frame_recv_reply(dynamic_read, &reply_sequence, &reply) == -1) {
+                        if (errno == EAGAIN) break;
+                        perror("read reply");
+                        quit = true;
+                        break;
+                    }
+                    if (acked == sequence || reply_sequence != acked + 1) {
+                        fprintf(stderr, "Unexpected reply %u (last sent %u)\n", reply_sequence, sequence);
+                        quit = true;
+                        break;
+                    }
+                    acked = reply_sequence;
+                    uint64_t start = latency_now();
+                    latency_record(&stages[STAGE_DYNAMICS], start - inflight_sent[acked % FRAME_PIPELINE_DEPTH]);
+                    // * The replies after the end of the game are dropped
+                    if (status != 2) continue;
+                    // * Compute the mean drone velocity
+                    const int prev_x = dronesim_cell(drone_pos[2]), prev_y = dronesim_cell(drone_pos[3]);
+                    const double pos[4] = {reply.x[0], reply.y[0], reply.x[1], reply.y[1]};
+                    int vel_x = dronesim_cell(pos[2]) - prev_x;
+                    int vel_y = dronesim_cell(pos[3]) - prev_y;
+                    // * Move the drone: remove any target along the path and update the score
+                    if (dronesim_apply_move(&game, pos, inflight_substeps[acked % FRAME_PIPELINE_DEPTH]) > 0) {
+                        map_changed = true;
+                    }
+                    latency_record(&stages[STAGE_APPLY_MOVE], latency_now() - start);
+                    // * Publish foce, postion and velocity of the drone for the inspector window
+                    start = latency_now();
+                    status_page.frame++;
+                    status_page.force_x = drone_force[0];
+                    status_page.force_y = -1*drone_force[1];
+                    status_page.pos_x = dronesim_cell(drone_pos[2]);
+                    status_page.pos_y = dronesim_cell(drone_pos[3]);
+                    status_page.vel_x = vel_x;
+                    status_page.vel_y = vel_y;
+                    status_page.score = game.score;
+                    status_page.key = inflight_key[acked % FRAME_PIPELINE_DEPTH];
+                    for (int i = 0; i < NUM_STAGES && i < TELEMETRY_MAX_STAGES; i++) {
+                        status_page.stages[i].count = stages[i].count;
+                        status_page.stages[i].last_ns = stages[i].last_ns;
+                        status_page.stages[i].max_ns = stages[i].max_ns;
+                    }
+                    telemetry_shm_publish(telemetry, &status_page);
+                    latency_record(&stages[STAGE_TELEMETRY], latency_now() - start);
+                    if (game.outcome == DRONESIM_WON) {
+                        status = -1;
+                        mvwprintw(win, height/2, width/2, "YOU WIN SCORE %d", game.score);
+                    }
+                    if (game.outcome == DRONESIM_LOST) {
+                        status = -1;
+                        mvwprintw(win, height/2, width/2, "GAME OVER");
                     }
                 }
-                // * Count the number of obstacles for the score
-                for (int r = 0; r < GAME_HEIGHT; r++) {
-                    for (int col = 0; col < GAME_WIDTH; col++) {
-                        if (grid[r][col] == 'o')
-                            count_obstacles++;
+            }
+        }
+        if (!frame_due || quit) continue;
+        const uint64_t frame_start = latency_now();
+        switch (status) {
+            case 0: { // * Menu
+                const char *message = map_ready ? "Press S to start or Q to quit" : "Waiting for the map...";
+                int msg_length = (int)strlen(message);
+                mvwprintw(win, height / 2, (width - msg_length) / 2, "%s", message);
+                // * Change the game status
+                for (int i = 0; i < num_keys && status == 0; i++) {
+                    if (keys[i] == 'q') status = -1;  // * Then quit
+                    if (keys[i] == 's' && map_ready) {
+                        status = 1;  // * Run the game
+                        werase(win);  // * Erase entire window
+                        renderer.invalidate();
                     }
                 }
-                // * Setting drone initial positions
-                drone_pos[0] = GAME_WIDTH / 2;
-                drone_pos[1] = GAME_HEIGHT / 2;
-                drone_pos[2] = GAME_WIDTH / 2;
-                drone_pos[3] = GAME_HEIGHT / 2;
+                num_keys = 0;
+                break;
+            }
+            case 1: { // * initialization
+                // * Clean the grid, count the obstacles and place the drone in the center
+                dronesim_reset(&game, grid);
+                dronesim_clock_start(&physics_clock);
+                map_changed = true;
+                state_flags = FRAME_FLAG_RESET;
                 // * Run the game
                 status = 2;
                 break;
             }
             case 2: { // * Running
-                // * Ssve the previous drone position to compute the velocity
-                int prev_x = drone_pos[0], prev_y = drone_pos[1];
-                // * Clean the previous position of the drone in the grid
-                grid[drone_pos[1]][drone_pos[0]] = ' ';
-                // * Draw the new map proportionally to the window dimension
-                for (int row = 1; row < GAME_HEIGHT-1; row++) {
-                    for (int col = 1; col < GAME_WIDTH-1; col++) {
-                        if (grid[row][col] == 'o') {
-                            wattron(win, COLOR_PAIR(3)); // * YELLOW for obstacles
-                            mvwprintw(win, row * height / GAME_HEIGHT, col * width / GAME_WIDTH, "o");
-                            wattroff(win, COLOR_PAIR(3));
-                            continue;
-                        }
-                        if (strchr("0123456789", grid[row][col])) {
-                            wattron(win, COLOR_PAIR(2)); // * GREEN for targets
-                            mvwprintw(win, row * height / GAME_HEIGHT, col * width / GAME_WIDTH, "%c", grid[row][col]);
-                            wattroff(win, COLOR_PAIR(2));
-                        }
-                    }
+                // * Compute the new forces of the drone from the keys of this frame
+                char key = '-';
+                for (int i = 0; i < num_keys; i++) {
+                    dronesim_command(drone_force, keys[i]);
+                    key = keys[i];
+                    if (keys[i] == 'q') status = -1;
                 }
-                // * Attempt to read a character from the keyboard pipe (non-blocking)
-                FD_ZERO(&read_keyboard);
-                FD_SET(keyboard, &read_keyboard);
-                timeout.tv_sec = 0;
-                timeout.tv_usec = 1e6/FRAME_RATE; // * Frame rate of ~60Hz
-                if (select(keyboard + 1, &read_keyboard, NULL, NULL, &timeout) > 0) {
-                    if (FD_ISSET(keyboard, &read_keyboard)) {
-                        const ssize_t bytesRead = read(keyboard, &c, 1);
-                        if (bytesRead == -1) {
-                            perror("read keyboard");
-                            break;
-                        }
-                    }
-                }
-                else {
-                    c = '\0';
+                num_keys = 0;
+                // * The drone is drawn at the newest position from dynamics, moved along its last velocity by the
+                // * steps still in flight: a late reply does not stop the drone on the screen
+                int pending = 0;
+                for (uint32_t s = acked + 1; s != sequence + 1; s++) {
+                    pending += inflight_substeps[s % FRAME_PIPELINE_DEPTH];
                 }
-                // * Clean the previous position of the drone in the map and draw the current
-                mvwprintw(win, drone_pos[1]*height/GAME_HEIGHT, drone_pos[0]*width/GAME_WIDTH, " ");
-                wattron(win, COLOR_PAIR(1)); // * BLUE for drone
-                mvwprintw(win, drone_pos[3]*height/GAME_HEIGHT, drone_pos[2]*width/GAME_WIDTH, "+");
-                wattroff(win, COLOR_PAIR(1));
-                // * Compute the new forces of the drone
-                command_drone(drone_force, c);
-                // * Send the new grid to drone dynamics
-                if (write(dynamic_write, grid, GAME_WIDTH * GAME_HEIGHT * sizeof(char)) == -1) {
-                    perror("write target");
-                    status = -1;
-                    c = 'q';
-                    break;
-                }
-                // * Send drone positions and forces generate by the user
-                char msg[100];
-                snprintf(msg, sizeof(msg), "%d,%d,%d,%d,%d,%d", drone_pos[0], drone_pos[1], drone_pos[2],
-                    drone_pos[3], drone_force[0], drone_force[1]);
-                if (write(dynamic_write, msg, sizeof(msg)) == -1) {
-                    perror("write");
-                    status = -1;
-                    c = 'q';
-                    break;
+                double shown_x, shown_y;
+                dronesim_extrapolate(drone_pos, pending, &shown_x, &shown_y);
+                // * Draw the map and the drone proportionally to the window dimension, only where they changed
+                const uint64_t draw_start = latency_now();
+                renderer.draw(win, game.grid, dronesim_cell(shown_x), dronesim_cell(shown_y));
+                latency_record(&stages[STAGE_DRAW], latency_now() - draw_start);
+                // * The next state is sent without waiting for the previous replies, up to the pipeline depth;
+                // * when dynamics lags further behind, the physics clock keeps the time until it catches up
+                if (sequence - acked >= FRAME_PIPELINE_DEPTH || status != 2) break;
+                // * Publish the grid to dynamics only if it changed
+                if (map_changed) {
+                    world_shm_publish(world, &game.cells);
+                    map_changed = false;
                 }
-                // * Retrieve the new position
-                char in_buf[32];
-                if (read(dynamic_read, in_buf, sizeof(in_buf)) == -1) {
-                    perror("write");
+                // * Send forces generate by the user and the physics steps due in this frame (and the drone
+                // * positions at the start of a game)
+                const int substeps = dronesim_clock_substeps(&physics_clock);
+                const frame_state_t state = {
+                    {drone_pos[0], drone_pos[2]}, {drone_pos[1], drone_pos[3]}, drone_force[0], drone_force[1],
+                    (uint32_t)substeps, 0
+                };
+                if (frame_send_state(dynamic_write, ++sequence, state_flags, &state) == -1) {
+                    perror("write state");
                     status = -1;
-                    c = 'q';
                     break;
                 }
-                drone_pos[0] = drone_pos[2];
-                drone_pos[1] = drone_pos[3];
-                if (sscanf(in_buf, "%d,%d", &drone_pos[2], &drone_pos[3]) != 2) {
-                    perror("sscanf");
-                    status = -1;
-                    c = 'q';
-                    break;
-                }
-                // * Compute the mean drone velocity
-                int vel_x = drone_pos[2] - prev_x;
-                int vel_y = drone_pos[3] - prev_y;
-                // * Remove any target along the path
-                remove_target_on_path(grid, prev_x, prev_y, drone_pos[2], drone_pos[3]);
-                // * Send the message containing foce, postion and velocity of the drone to the inspector window
-                char insp_msg[128];
-                char key;
-                if (c == '\0') key = '-';
-                else key = c;
-                snprintf(insp_msg, sizeof(insp_msg), "%d,%d,%d,%d,%d,%d,%c", drone_force[0], -1*drone_force[1],
-                    drone_pos[2], drone_pos[3], vel_x, vel_y, key);
-                const int fd = open(INSPECTOR_FIFO, O_WRONLY);
-                if (write(fd, insp_msg, strlen(insp_msg)) == -1) {
-                    perror("write insp_pipe");
-                    status = -1;
-                    c = 'q';
-                }
-                close(fd);
-                // * Update the traveled distance
-                distance_traveled += abs(drone_pos[2] - prev_x) + abs(drone_pos[3] - prev_y);
-                // * Compute the time
-                int elapsed_time = (int)(time(NULL) - start_time);
-                // * Count the remaining targets
-                int count_targets = 0;
-                for (int r = 0; r < GAME_HEIGHT; r++) {
-                    for (int col = 0; col < GAME_WIDTH; col++) {
-                        if (strchr("0123456789", grid[r][col]) != NULL)
-                            count_targets++;
-                    }
-                }
-                // * Compute the loss score
-                score -= elapsed_time * 10 + distance_traveled * 5 + count_obstacles/((10 -count_targets) * 3000);
-                if (score < 0) score = 0;
-                if (count_targets == 0) {
-                    status = -1;
-                    c = 'q';
-                    mvwprintw(win, height/2, width/2, "YOU WIN SCORE %d", score);
-                }
-                if (score <= 0) {
-                    status = -1;
-                    c = 'q';
-                    mvwprintw(win, height/2, width/2, "GAME OVER");
-                }
-                if (c == 'q') {
-                    status = -1;
-                }
+                state_flags = 0;
+                inflight_sent[sequence % FRAME_PIPELINE_DEPTH] = latency_now();
+                inflight_substeps[sequence % FRAME_PIPELINE_DEPTH] = substeps;
+                inflight_key[sequence % FRAME_PIPELINE_DEPTH] = key;
                 break;
             }
             default: break;
@@ -599,18 +968,40 @@ int main(const int argc, char *argv[]) {
             // * Delete old window and create a new one
             delwin(win);
             win = newwin(height, width, 0, 0);
+            renderer.invalidate();
         }
         // * Draw border for new window
         box(win, 0, 0);   // * Redraw border
         // * Print the score
-        mvwprintw(win, 0, 4, "Score: %d", score);
+        mvwprintw(win, 0, 4, "Score: %d", game.score);
         mvwprintw(win, 0, width-20, "Press q to quit");
+        // * Only the window is drawn on: one refresh sends just the changed cells to the terminal
+        const uint64_t refresh_start = latency_now();
         wrefresh(win);
-        refresh();  // * Ensure standard screen updates
-        // * Refresh the standard screen and the new window
-        wrefresh(win);
-        wrefresh(stdscr);
-    } while (!(status == -1  && c == 'q')); // * Exit on 'q' and if status is -1
+        const uint64_t frame_end = latency_now();
+        latency_record(&stages[STAGE_REFRESH], frame_end - refresh_start);
+        latency_record(&stages[STAGE_FRAME], frame_end - frame_start);
+        if (frame_end >= next_percentiles) {
+            for (int i = 0; i < NUM_STAGES && i < TELEMETRY_MAX_STAGES; i++) {
+                status_page.stages[i].count = stages[i].count;
+                status_page.stages[i].p50_ns = latency_percentile(&stages[i], 50.0);
+                status_page.stages[i].p99_ns = latency_percentile(&stages[i], 99.0);
+                status_page.stages[i].max_ns = stages[i].max_ns;
+            }
+            status_page.stats_seq++;
+            telemetry_shm_publish(telemetry, &status_page);
+            next_percentiles = frame_end + 1000000000u;
+        }
+        if (frame_end >= next_stats) {
+            dump_stats(NULL, stages);
+            next_stats = frame_end + (uint64_t)(STATS_PERIOD * 1e9);
+        }
+        // * Exit once the last frame is shown
+        if (status == -1) quit = true;
+    }
+    delete mysub;
+    event_loop_close(&loop);
+    dump_stats(logfile, stages);
 
     // * Close the inspector window
     kill(-insp_pid, SIGTERM);
@@ -625,6 +1016,8 @@ int main(const int argc, char *argv[]) {
         close(read_fds[i]);
     }
     close(write_fds);
+    telemetry_shm_close(telemetry);
+    world_shm_close(world);
     fclose(logfile);
 
     return EXIT_SUCCESS;
@@ -689,36 +1082,6 @@ int initialize_ncurses() {
     return EXIT_SUCCESS;
 }
 
-void command_drone(int *drone_force, char c) {
-    /*
-     * Modify the drone force based on the input key.
-     * Command keys:
-     * 'w': Up Left, 'e': Up, 'r': Up Right or Reset,
-     * 's': Left or Suspend, 'd': Brake, 'f': Right,
-     * 'x': Down Left, 'c': Down, 'v': Down Right,
-     * 'p': Pause, 'q': Quit
-     * -------
-     * @param drone_force Array representing the drone's force.
-     * @param c The input character.
-    */
-    if (strchr("wsx", c)) {
-        drone_force[0]--;
-    }
-    if (strchr("rfv", c)) {
-        drone_force[0]++;
-    }
-    if (strchr("wer", c)) {
-        drone_force[1]--;
-    }
-    if (strchr("xcv", c)) {
-        drone_force[1]++;
-    }
-    if (c == 'd') {
-        drone_force[0] = 0;
-        drone_force[1] = 0;
-    }
-}
-
 pid_t launch_inspection_window() {
     /*
      * Launches a new terminal window running the "inspector" program.
@@ -742,35 +1105,39 @@ pid_t launch_inspection_window() {
     return pid;
 }
 
-void remove_target_on_path(char grid[GAME_HEIGHT][GAME_WIDTH], int x0, int y0, int x1, int y1) {
-    // * To see more about this -> "https://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm"
-    // * Compute the directions
-    int dx = abs(x1 - x0);
-    int sx = (x0 < x1) ? 1 : -1;
-    int dy = -abs(y1 - y0);
-    int sy = (y0 < y1) ? 1 : -1;
-    // * Starting Bresenham's error
-    int err = dx + dy;
-    while (1) {
-        // * Check if the drone is inside the grid
-        if (x0 >= 0 && x0 < GAME_WIDTH && y0 >= 0 && y0 < GAME_HEIGHT) {
-            if (strchr("0123456789", grid[y0][x0]) != NULL) {
-                grid[y0][x0] = ' ';
-            }
-        }
-        // * Stop when it is reached the last point (x1, y1)
-        if (x0 == x1 && y0 == y1) {
-            break;
-        }
-        // * Update the e2
-        int e2 = 2 * err;
-        if (e2 >= dy) {
-            err += dy;
-            x0  += sx;
-        }
-        if (e2 <= dx) {
-            err += dx;
-            y0  += sy;
+void dump_stats(FILE *out, const latency_histogram_t *stages) {
+    /*
+     * Write the latency of the frame stages to STATS_FILE (replacing it) and, if given, to another file.
+     * @param out Also written there, NULL for none.
+     * @param stages Histograms of the stages.
+    */
+    FILE *stats = fopen(STATS_FILE, "w");
+    if (stats) {
+        latency_report(stats, stages, NUM_STAGES);
+        fclose(stats);
+    }
+    if (out) {
+        fprintf(out, "PID: %d - Blackboard frame latency:\n", getpid());
+        latency_report(out, stages, NUM_STAGES);
+    }
+}
+
+void log_startup(const char *event, const uint64_t start) {
+    /*
+     * Write to the logfile the time elapsed since the DDS setup started and the resident memory (VmRSS).
+     * @param event What happened.
+     * @param start latency_now() when the DDS setup started.
+    */
+    long rss_kb = -1;
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status) {
+        char line[128];
+        while (fgets(line, sizeof(line), status)) {
+            if (sscanf(line, "VmRSS: %ld kB", &rss_kb) == 1) break;
         }
+        fclose(status);
     }
-}
\ No newline at end of file
+    fprintf(logfile, "PID: %d - Blackboard DDS %s after %.1f ms, VmRSS %ld kB\n", getpid(), event,
+            (latency_now() - start) / 1e6, rss_kb);
+    fflush(logfile);
+}
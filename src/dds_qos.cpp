@@ -0,0 +1,99 @@
+//
+// Created by Gian Marco Balia
+//
+// src/dds_qos.cpp
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "dds_qos.h"
+
+#include <fastdds/dds/domain/DomainParticipantFactory.hpp>
+
+using namespace eprosima::fastdds::dds;
+
+static bool profiles_loaded = false;
+
+static void default_path(char *path, const size_t size) {
+    // * QOS_FILE_DEFAULT in the directory of the executable, whatever the working directory
+    const ssize_t length = readlink("/proc/self/exe", path, size - 1);
+    char *slash = length > 0 ? (char *)memrchr(path, '/', (size_t)length) : nullptr;
+    if (slash == nullptr) {
+        snprintf(path, size, "%s", QOS_FILE_DEFAULT);
+        return;
+    }
+    snprintf(slash + 1, size - (size_t)(slash + 1 - path), "%s", QOS_FILE_DEFAULT);
+}
+
+bool dds_qos_load(FILE *log) {
+    /*
+     * Load the XML profiles file QOS_FILE_ENV (QOS_FILE_DEFAULT next to the executable if not set), before making
+     * the writers or readers.
+     * @param log Where the source of the QoS in use is written (the file, or the defaults).
+     * @return true if the profiles were loaded, false to use the default QoS.
+    */
+    char path[PATH_MAX];
+    const char *chosen = getenv(QOS_FILE_ENV);
+    if (chosen != nullptr && *chosen != '\0') {
+        snprintf(path, sizeof(path), "%s", chosen);
+    } else {
+        chosen = nullptr;
+        default_path(path, sizeof(path));
+    }
+    // * The default file is optional, a file chosen by the user is not
+    if (chosen == nullptr && access(path, R_OK) == -1) {
+        profiles_loaded = false;
+        fprintf(log, "PID: %d - QoS: defaults (no profiles in \"%s\")\n", getpid(), path);
+        fflush(log);
+        return false;
+    }
+    profiles_loaded = DomainParticipantFactory::get_instance()->load_XML_profiles_file(path) == RETCODE_OK;
+    if (profiles_loaded) {
+        fprintf(log, "PID: %d - QoS: profiles of \"%s\"\n", getpid(), path);
+    } else {
+        fprintf(log, "PID: %d - QoS: defaults (cannot load the profiles of \"%s\")\n", getpid(), path);
+    }
+    fflush(log);
+    return profiles_loaded;
+}
+
+template <typename Qos>
+static void durable(Qos &qos, const int instances) {
+    // * Only the last map, kept for the readers matched later: one sample per instance
+    qos.durability().kind = TRANSIENT_LOCAL_DURABILITY_QOS;
+    qos.reliability().kind = RELIABLE_RELIABILITY_QOS;
+    qos.history().kind = KEEP_LAST_HISTORY_QOS;
+    qos.history().depth = 1;
+    qos.resource_limits().max_instances = instances;
+    qos.resource_limits().max_samples = instances;
+    qos.resource_limits().max_samples_per_instance = 1;
+}
+
+void dds_qos_writer(const Publisher *publisher, const Topic *topic, const int instances, DataWriterQos &qos) {
+    /*
+     * QoS of a writer of a map topic: its profile if any, otherwise the durable default.
+     * @param topic The topic, whose name is the name of the profile.
+     * @param instances Instances of the topic: 1 for a layer, BITGRID_CELLS for the MapItem cells.
+     * @param qos The QoS, overwritten.
+    */
+    qos = DATAWRITER_QOS_DEFAULT;
+    durable(qos, instances);
+    if (profiles_loaded) {
+        publisher->get_datawriter_qos_from_profile(topic->get_name(), qos);
+    }
+}
+
+void dds_qos_reader(const Subscriber *subscriber, const Topic *topic, const int instances, DataReaderQos &qos) {
+    /*
+     * QoS of a reader of a map topic: its profile if any, otherwise the durable default.
+     * @param topic The topic, whose name is the name of the profile.
+     * @param instances Instances of the topic: 1 for a layer, BITGRID_CELLS for the MapItem cells.
+     * @param qos The QoS, overwritten.
+    */
+    qos = DATAREADER_QOS_DEFAULT;
+    durable(qos, instances);
+    if (profiles_loaded) {
+        subscriber->get_datareader_qos_from_profile(topic->get_name(), qos);
+    }
+}
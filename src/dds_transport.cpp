@@ -0,0 +1,95 @@
+//
+// Created by Gian Marco Balia
+//
+// src/dds_transport.cpp
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include "dds_transport.h"
+
+#include <fastdds/rtps/common/Locator.hpp>
+#include <fastdds/rtps/transport/shared_mem/SharedMemTransportDescriptor.hpp>
+#include <fastdds/rtps/transport/TCPv4TransportDescriptor.hpp>
+#include <fastdds/rtps/transport/UDPv4TransportDescriptor.hpp>
+#include <fastdds/utils/IPLocator.hpp>
+
+using namespace eprosima::fastdds::dds;
+using namespace eprosima::fastdds::rtps;
+
+int dds_transport_mode() {
+    /*
+     * Transport chosen with TRANSPORT_ENV ("tcp" if not set).
+     * @return DDS_TRANSPORT_TCP, DDS_TRANSPORT_SHM or DDS_TRANSPORT_UDP.
+    */
+    const char *value = getenv(TRANSPORT_ENV);
+    if (value == nullptr || *value == '\0' || strcmp(value, "tcp") == 0) return DDS_TRANSPORT_TCP;
+    if (strcmp(value, "shm") == 0) return DDS_TRANSPORT_SHM;
+    if (strcmp(value, "udp") == 0) return DDS_TRANSPORT_UDP;
+    fprintf(stderr, "Unknown %s \"%s\": using tcp\n", TRANSPORT_ENV, value);
+    return DDS_TRANSPORT_TCP;
+}
+
+static void add_transports(DomainParticipantQos &qos, const int mode, const uint16_t tcp_port) {
+    // * Shared memory first, for the data between the processes of the host; TCP for the discovery servers.
+    // * UDP alone in UDP mode
+    qos.transport().use_builtin_transports = false;
+    if (mode == DDS_TRANSPORT_UDP) {
+        qos.transport().user_transports.push_back(std::make_shared<UDPv4TransportDescriptor>());
+        return;
+    }
+    if (mode == DDS_TRANSPORT_SHM) {
+        auto shm_transport = std::make_shared<SharedMemTransportDescriptor>();
+        shm_transport->segment_size(DDS_SHM_SEGMENT_BYTES);
+        qos.transport().user_transports.push_back(shm_transport);
+    }
+    auto tcp_transport = std::make_shared<TCPv4TransportDescriptor>();
+    tcp_transport->add_listener_port(tcp_port);
+    qos.transport().user_transports.push_back(tcp_transport);
+}
+
+static Locator_t server_locator(const int mode, const char *ip, const uint16_t port) {
+    // * The locator kind follows the transport that carries the discovery: UDPv4 in UDP mode, TCPv4 otherwise
+    // * (TCP and SHM), where the TCP locators also need the logical port
+    Locator_t locator;
+    locator.kind = mode == DDS_TRANSPORT_UDP ? LOCATOR_KIND_UDPv4 : LOCATOR_KIND_TCPv4;
+    IPLocator::setIPv4(locator, ip);
+    IPLocator::setPhysicalPort(locator, port);
+    if (mode != DDS_TRANSPORT_UDP) IPLocator::setLogicalPort(locator, port);
+    return locator;
+}
+
+void dds_transport_server(DomainParticipantQos &qos, const int mode, const char *ip, const uint16_t port) {
+    /*
+     * Configure a participant as discovery SERVER listening on ip:port.
+     * @param qos The participant QoS.
+     * @param mode DDS_TRANSPORT_TCP, DDS_TRANSPORT_SHM or DDS_TRANSPORT_UDP.
+    */
+    qos.wire_protocol().builtin.discovery_config.discoveryProtocol = DiscoveryProtocol::SERVER;
+    add_transports(qos, mode, port);
+    qos.wire_protocol().builtin.metatrafficUnicastLocatorList.push_back(server_locator(mode, ip, port));
+}
+
+void dds_transport_client(DomainParticipantQos &qos, const int mode) {
+    /*
+     * Configure a participant as discovery CLIENT (port chosen by the system): add its servers with
+     * dds_transport_add_server.
+    */
+    qos.wire_protocol().builtin.discovery_config.discoveryProtocol = DiscoveryProtocol::CLIENT;
+    add_transports(qos, mode, 0);
+}
+
+void dds_transport_add_server(DomainParticipantQos &qos, const int mode, const char *ip, const uint16_t port) {
+    qos.wire_protocol().builtin.discovery_config.m_DiscoveryServers.push_back(server_locator(mode, ip, port));
+}
+
+void dds_transport_data_sharing(DataWriterQos &qos, const int mode) {
+    // * Data-sharing only in shared-memory mode (Fast DDS would otherwise pick it for the bounded types)
+    if (mode == DDS_TRANSPORT_SHM) qos.data_sharing().automatic();
+    else qos.data_sharing().off();
+}
+
+void dds_transport_data_sharing(DataReaderQos &qos, const int mode) {
+    if (mode == DDS_TRANSPORT_SHM) qos.data_sharing().automatic();
+    else qos.data_sharing().off();
+}
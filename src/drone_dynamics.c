@@ -11,6 +11,9 @@
 #include <signal.h>
 #include <ncurses.h>
 #include "macros.h"
+#include "dronesim.h"
+#include "frame_protocol.h"
+#include "world_shm.h"
 
 FILE *logfile;
 static volatile sig_atomic_t keep_running = 1;
@@ -65,77 +68,57 @@ int main(int argc, char *argv[]) {
     perror("fdopen logfile");
     return EXIT_FAILURE;
   }
+  // * Map the shared grid written by the Blackboard
+  world_shm_t *world = world_shm_open(0);
+  if (!world) {
+    return EXIT_FAILURE;
+  }
+  // * Force field of the map, updated only around the changed cells when a new grid is published
+  static force_field_t field;
+  static bitgrid_t cells;
+  bitgrid_clear(&cells);
+  force_field_build(&field, &cells);
+  uint32_t field_generation = 1;            // * Odd: never a stable generation
+  // * Previous and current drone position, kept between frames and set by the Blackboard at every new game
+  double pos[4] = {GAME_WIDTH / 2, GAME_HEIGHT / 2, GAME_WIDTH / 2, GAME_HEIGHT / 2};
   while(keep_running) {
-    // * Receive the updated map
-    char grid[GAME_HEIGHT][GAME_WIDTH];
-    memset(grid, ' ', GAME_HEIGHT*GAME_WIDTH);
-    if (read(read_fd, grid, GAME_HEIGHT * GAME_WIDTH * sizeof(char)) != GAME_HEIGHT * GAME_WIDTH * sizeof(char)) {
-      perror("read grid");
-      return EXIT_FAILURE;
-    }
-    // * Read the drone position and force
-    char msg[100];
-    if (read(read_fd, msg, sizeof(msg)) == -1) {
-      perror("read");
+    // * Receive the force and the steps to run (and the drone position at the start of a game)
+    uint32_t sequence;
+    uint8_t flags;
+    frame_state_t state;
+    if (frame_recv_state(read_fd, &sequence, &flags, &state) == -1) {
+      perror("read state");
+      world_shm_close(world);
       return EXIT_FAILURE;
     }
-    int x[2], y[2], force_x, force_y;
-    if (sscanf(msg, "%d,%d,%d,%d,%d,%d", &x[0], &y[0], &x[1], &y[1], &force_x, &force_y) != 6) {
-      fprintf(stderr, "Failed to parse message: %s\n", msg);
-      return EXIT_FAILURE;
-    }
-    // * Declare the total force
-    double Fx = (double)force_x/10, Fy = (double)force_y/10;
-    // * Compute the repulsive and attractive forces
-    for (int i = 0; i < GAME_HEIGHT; i++) {
-      for (int j = 0; j < GAME_WIDTH; j++) {
-        const char cell = grid[i][j];
-        if (cell == ' ') continue;
-        const int dx = x[1] - j;
-        const int dy = y[1] - i;
-        double dist = sqrt((double)dx*dx + (double)dy*dy);
-        // * Repulsive forces
-        dist = dist < MIN_RHO_OBST ? MIN_RHO_OBST : dist;
-        if (dist < RHO_OBST && cell == 'o') {
-          Fx -= ETA*(1/dist - 1/RHO_OBST)*dx/pow(dist,3);
-          Fy -= ETA*(1/dist - 1/RHO_OBST)*dy/pow(dist,3);
-          continue;
-        }
-        // * Attractive forces
-        dist = sqrt((double)dx*dx + (double)dy*dy);
-        dist = dist < MIN_RHO_TRG ? MIN_RHO_TRG : dist;
-        if (dist < RHO_TRG && strchr("0123456789", cell)) {
-          Fx -= EPSILON*(double)dx/dist;
-          Fy -= EPSILON*(double)dy/dist;
-        }
+    // * Copy the grid if a new one was published (again if the writer raced with us) and update the field
+    uint32_t generation;
+    while ((generation = seqlock_read_begin(&world->lock)) != field_generation) {
+      memcpy(&cells, &world->cells, sizeof(cells));
+      if (!seqlock_read_retry(&world->lock, generation)) {
+        force_field_update(&field, &cells);
+        field_generation = generation;
       }
     }
-    // * Compute the position from the force
-    int x_new = (int)(
-            (TIME*TIME*Fx - DRONE_MASS*x[0] + (2*DRONE_MASS + DAMPING*TIME)*x[1]) / (DRONE_MASS + DAMPING*TIME)
-        );
-    int y_new = (int)(
-        (TIME*TIME*Fy - DRONE_MASS*y[0] + (2*DRONE_MASS + DAMPING*TIME)*y[1]) / (DRONE_MASS + DAMPING*TIME)
-    );
-    // * Clamp to window boundaries so we do not jump outside:
-    if (x_new < 3) {
-      x_new = 3;
-    } else if (x_new > GAME_WIDTH - 3) {
-      x_new = GAME_WIDTH - 3;
-    }
-    if (y_new < 3) {
-      y_new = 3;
-    } else if (y_new > GAME_HEIGHT - 3) {
-      y_new = GAME_HEIGHT - 3;
+    // * Advance the drone by the fixed physics steps due in this frame
+    if (flags & FRAME_FLAG_RESET) {
+      pos[0] = state.x[0];
+      pos[1] = state.y[0];
+      pos[2] = state.x[1];
+      pos[3] = state.y[1];
     }
+    const int force[2] = {state.force_x, state.force_y};
+    const int substeps = state.substeps > PHYSICS_MAX_SUBSTEPS ? PHYSICS_MAX_SUBSTEPS : (int)state.substeps;
+    dronesim_physics(&field, pos, force, substeps);
     // * Send the new position of the drone
-    char out_buf[32];
-    sprintf(out_buf, "%d,%d", x_new, y_new);
-    if (write(write_fd, out_buf, sizeof(out_buf)) == -1) {
+    const frame_reply_t reply = {{pos[0], pos[2]}, {pos[1], pos[3]}};
+    if (frame_send_reply(write_fd, sequence, &reply) == -1) {
       perror("write");
+      world_shm_close(world);
       return EXIT_FAILURE;
     }
   }
+  world_shm_close(world);
   return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,338 @@
+//
+// Created by Gian Marco Balia
+//
+// src/dronesim.c
+#include <stdlib.h>
+#include <string.h>
+#include "dronesim.h"
+
+static void copy_map(dronesim_state_t *state, const char grid[GAME_HEIGHT][GAME_WIDTH]) {
+    // * Clean possible dirties in the grid, free the drone cell and count the obstacles for the score
+    for (int row = 0; row < GAME_HEIGHT; row++) {
+        for (int col = 0; col < GAME_WIDTH; col++) {
+            state->grid[row][col] = BITGRID_CELL_CLASS(grid[row][col]) != CELL_EMPTY ? grid[row][col] : ' ';
+        }
+    }
+    state->grid[dronesim_cell(state->drone_pos[3])][dronesim_cell(state->drone_pos[2])] = ' ';
+    bitgrid_from_chars(&state->cells, state->grid);
+    state->count_obstacles = bitgrid_count(state->cells.obstacles);
+    state->count_targets = bitgrid_count(state->cells.targets);
+}
+
+void dronesim_reset(dronesim_state_t *state, const char grid[GAME_HEIGHT][GAME_WIDTH]) {
+    /*
+     * Start a new game on a map.
+     * @param state The game to (re)initialise.
+     * @param grid The map: anything but obstacles and targets is discarded.
+    */
+    // * Setting drone initial positions
+    state->drone_pos[0] = GAME_WIDTH / 2;
+    state->drone_pos[1] = GAME_HEIGHT / 2;
+    state->drone_pos[2] = GAME_WIDTH / 2;
+    state->drone_pos[3] = GAME_HEIGHT / 2;
+    copy_map(state, grid);
+    state->drone_force[0] = 0;
+    state->drone_force[1] = 0;
+    // * Score variables
+    state->score = MAX_SCORE;
+    state->distance_traveled = 0;
+    state->elapsed_time = 0;
+    state->steps = 0;
+    state->frame = 0;
+    state->outcome = DRONESIM_PLAYING;
+    force_field_build(&state->field, &state->cells);
+}
+
+int dronesim_load_map(dronesim_state_t *state, const char grid[GAME_HEIGHT][GAME_WIDTH]) {
+    /*
+     * Bring the obstacles of a new map into a game in progress: the drone, its force, the score and the time go
+     * on, and so do the targets, with their digits (a taken target stays taken, the targets of a map are placed
+     * by dronesim_reset at the start of a game). Only the changed obstacles are touched, also in the field.
+     * @param state The game.
+     * @param grid The new map: anything but obstacles is discarded.
+     * @return Number of grid cells changed.
+    */
+    bitgrid_t next;
+    bitgrid_from_chars(&next, grid);
+    int changed = 0;
+    for (int word = 0; word < BITGRID_WORDS; word++) {
+        for (uint64_t diff = state->cells.obstacles[word] ^ next.obstacles[word]; diff != 0; diff &= diff - 1) {
+            const int index = word * 64 + __builtin_ctzll(diff);
+            changed += dronesim_set_obstacle(state, index % GAME_WIDTH, index / GAME_WIDTH,
+                bitgrid_test(next.obstacles, index));
+        }
+    }
+    if (changed > 0) {
+        force_field_update(&state->field, &state->cells);
+    }
+    return changed;
+}
+
+int dronesim_set_obstacle(dronesim_state_t *state, const int col, const int row, const int present) {
+    /*
+     * Add or remove an obstacle in a game in progress. A target keeps its cell, and no obstacle appears within
+     * DRONESIM_CLEAR_RADIUS of the drone. The force field is left to the caller (force_field_update, once
+     * after a batch of cells).
+     * @param col, row The cell, ignored if outside the map.
+     * @param present 1 to add the obstacle, 0 to remove it.
+     * @return 1 if the cell changed, 0 otherwise.
+    */
+    if (col < 0 || col >= GAME_WIDTH || row < 0 || row >= GAME_HEIGHT) {
+        return 0;
+    }
+    const int index = bitgrid_index(col, row);
+    if (bitgrid_test(state->cells.obstacles, index) == (present != 0)) {
+        return 0;
+    }
+    if (present) {
+        if (bitgrid_test(state->cells.targets, index) ||
+            (abs(col - dronesim_cell(state->drone_pos[2])) <= DRONESIM_CLEAR_RADIUS &&
+             abs(row - dronesim_cell(state->drone_pos[3])) <= DRONESIM_CLEAR_RADIUS)) {
+            return 0;
+        }
+        bitgrid_set(state->cells.obstacles, index);
+        state->grid[row][col] = 'o';
+        state->count_obstacles++;
+    } else {
+        bitgrid_reset(state->cells.obstacles, index);
+        state->grid[row][col] = ' ';
+        state->count_obstacles--;
+    }
+    return 1;
+}
+
+void dronesim_command(int drone_force[2], const char key) {
+    /*
+     * Modify the drone force based on the input key.
+     * Command keys:
+     * 'w': Up Left, 'e': Up, 'r': Up Right or Reset,
+     * 's': Left or Suspend, 'd': Brake, 'f': Right,
+     * 'x': Down Left, 'c': Down, 'v': Down Right,
+     * 'p': Pause, 'q': Quit
+     * -------
+     * @param drone_force Array representing the drone's force.
+     * @param key The input character.
+    */
+    if (key == '\0') {
+        return;
+    }
+    if (strchr("wsx", key)) {
+        drone_force[0]--;
+    }
+    if (strchr("rfv", key)) {
+        drone_force[0]++;
+    }
+    if (strchr("wer", key)) {
+        drone_force[1]--;
+    }
+    if (strchr("xcv", key)) {
+        drone_force[1]++;
+    }
+    if (key == 'd') {
+        drone_force[0] = 0;
+        drone_force[1] = 0;
+    }
+}
+
+void dronesim_physics(const force_field_t *field, double pos[4], const int force[2], const int substeps) {
+    /*
+     * Advance the drone by a number of fixed physics steps.
+     * @param field Force field of the map.
+     * @param pos Previous (x, y) and current (x, y) drone position, replaced by the ones after the last step.
+     * @param force Force generated by the user.
+     * @param substeps Number of steps of DRONESIM_STEP_TIME.
+    */
+    const double h = DRONESIM_STEP_TIME;
+    for (int step = 0; step < substeps; step++) {
+        // * Declare the total force: the user's one plus the repulsive and attractive forces of the map
+        double Fx, Fy;
+        force_field_sample(field, pos[2], pos[3], &Fx, &Fy);
+        Fx += (double)force[0]/10;
+        Fy += (double)force[1]/10;
+        // * Compute the position from the force
+        double x_new = (h*h*Fx - DRONE_MASS*pos[0] + (2*DRONE_MASS + DAMPING*h)*pos[2]) / (DRONE_MASS + DAMPING*h);
+        double y_new = (h*h*Fy - DRONE_MASS*pos[1] + (2*DRONE_MASS + DAMPING*h)*pos[3]) / (DRONE_MASS + DAMPING*h);
+        // * Clamp to window boundaries so we do not jump outside:
+        if (x_new < 3) {
+            x_new = 3;
+        } else if (x_new > GAME_WIDTH - 3) {
+            x_new = GAME_WIDTH - 3;
+        }
+        if (y_new < 3) {
+            y_new = 3;
+        } else if (y_new > GAME_HEIGHT - 3) {
+            y_new = GAME_HEIGHT - 3;
+        }
+        pos[0] = pos[2];
+        pos[1] = pos[3];
+        pos[2] = x_new;
+        pos[3] = y_new;
+    }
+}
+
+int dronesim_remove_targets_on_path(char grid[GAME_HEIGHT][GAME_WIDTH], bitgrid_t *cells, int x0, int y0,
+    const int x1, const int y1) {
+    /*
+     * Remove the targets on the segment travelled by the drone.
+     * @param grid The char grid, NULL if there is none.
+     * @param cells The bitsets of the grid.
+     * @return Number of removed targets.
+    */
+    // * To see more about this -> "https://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm"
+    // * Compute the directions
+    const int dx = abs(x1 - x0);
+    const int sx = (x0 < x1) ? 1 : -1;
+    const int dy = -abs(y1 - y0);
+    const int sy = (y0 < y1) ? 1 : -1;
+    // * Starting Bresenham's error
+    int err = dx + dy;
+    int removed = 0;
+    while (1) {
+        // * Check if the drone is inside the grid
+        if (x0 >= 0 && x0 < GAME_WIDTH && y0 >= 0 && y0 < GAME_HEIGHT) {
+            const int index = bitgrid_index(x0, y0);
+            if (bitgrid_test(cells->targets, index)) {
+                bitgrid_reset(cells->targets, index);
+                if (grid != NULL) grid[y0][x0] = ' ';
+                removed++;
+            }
+        }
+        // * Stop when it is reached the last point (x1, y1)
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        // * Update the e2
+        const int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0  += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0  += sy;
+        }
+    }
+    return removed;
+}
+
+int dronesim_score(int *score, const int distance_traveled, const double elapsed_time, const int count_obstacles,
+    const int count_targets, const int substeps) {
+    /*
+     * Subtract the loss of a frame from the score. The loss is charged per physics step, so the score does
+     * not depend on how many frames were rendered, and the time counts in tenths of a second.
+     * @param score The score, never below zero.
+     * @param distance_traveled, elapsed_time Distance and seconds since the start of the game.
+     * @param count_obstacles, count_targets Obstacles of the map and targets still to take.
+     * @param substeps Physics steps of the frame.
+     * @return The outcome of the game after this frame.
+    */
+    const int missing_targets = 10 - count_targets;
+    const long long loss = (long long)(elapsed_time * 10) + distance_traveled * 5 +
+        (missing_targets > 0 ? count_obstacles/(missing_targets * 3000) : 0);
+    const long long charged = loss * substeps / PHYSICS_SUBSTEPS;
+    *score = charged >= *score ? 0 : *score - (int)charged;
+    if (*score <= 0) {
+        return DRONESIM_LOST;
+    }
+    return count_targets == 0 ? DRONESIM_WON : DRONESIM_PLAYING;
+}
+
+int dronesim_apply_move(dronesim_state_t *state, const double pos[4], const int substeps) {
+    /*
+     * Apply the new drone position to the game: targets on the path, score and outcome.
+     * @param state The game.
+     * @param pos Previous (x, y) and current (x, y) drone position after the frame (see dronesim_physics).
+     * @param substeps Physics steps of the frame.
+     * @return Number of grid cells changed (the caller must refresh anything derived from the grid).
+    */
+    const int prev_x = dronesim_cell(state->drone_pos[2]), prev_y = dronesim_cell(state->drone_pos[3]);
+    const int x_new = dronesim_cell(pos[2]), y_new = dronesim_cell(pos[3]);
+    memcpy(state->drone_pos, pos, sizeof(state->drone_pos));
+    // * Remove any target along the path
+    int changed = dronesim_remove_targets_on_path(state->grid, &state->cells, prev_x, prev_y, x_new, y_new);
+    // * Update the traveled distance and the time
+    state->distance_traveled += abs(x_new - prev_x) + abs(y_new - prev_y);
+    state->steps += substeps;
+    state->elapsed_time = (double)state->steps * DRONESIM_STEP_SECONDS;
+    // * The targets taken are the only change to the counts during a game
+    state->count_targets -= changed;
+    state->outcome = dronesim_score(&state->score, state->distance_traveled, state->elapsed_time,
+        state->count_obstacles, state->count_targets, substeps);
+    // * The drone leaves the cell it was in: it is cleaned before the next frame (a target there was already
+    // * taken, and counted, by the path, which starts from this cell)
+    const int left = bitgrid_index(prev_x, prev_y);
+    if (bitgrid_test(state->cells.obstacles, left)) {
+        bitgrid_reset(state->cells.obstacles, left);
+        changed++;
+    }
+    state->grid[prev_y][prev_x] = ' ';
+    state->frame++;
+    return changed;
+}
+
+int dronesim_step(dronesim_state_t *state, const dronesim_input_t *input) {
+    /*
+     * Run a whole frame of the game.
+     * @param state The game, initialised by dronesim_reset.
+     * @param input Key pressed and physics steps of the frame.
+     * @return The outcome of the game (DRONESIM_PLAYING while it goes on).
+    */
+    if (state->outcome != DRONESIM_PLAYING) {
+        return state->outcome;
+    }
+    dronesim_command(state->drone_force, input->key);
+    double pos[4];
+    memcpy(pos, state->drone_pos, sizeof(pos));
+    dronesim_physics(&state->field, pos, state->drone_force, input->substeps);
+    if (dronesim_apply_move(state, pos, input->substeps) > 0) {
+        force_field_update(&state->field, &state->cells);
+    }
+    if (input->key == 'q' && state->outcome == DRONESIM_PLAYING) {
+        state->outcome = DRONESIM_QUIT;
+    }
+    return state->outcome;
+}
+
+void dronesim_extrapolate(const double pos[4], const int substeps, double *x, double *y) {
+    /*
+     * Guess where the drone will be after some physics steps, moving at its last velocity. Used to draw the
+     * drone while the steps are still being computed.
+     * @param pos Previous (x, y) and current (x, y) drone position (see dronesim_physics).
+     * @param substeps Physics steps not computed yet.
+     * @param x, y Extrapolated position, inside the same bounds as the physics.
+    */
+    *x = pos[2] + (pos[2] - pos[0]) * substeps;
+    *y = pos[3] + (pos[3] - pos[1]) * substeps;
+    *x = *x < 3 ? 3 : (*x > GAME_WIDTH - 3 ? GAME_WIDTH - 3 : *x);
+    *y = *y < 3 ? 3 : (*y > GAME_HEIGHT - 3 ? GAME_HEIGHT - 3 : *y);
+}
+
+void dronesim_clock_start(dronesim_clock_t *clock) {
+    /*
+     * Start the real-time clock of a game, with nothing to simulate.
+    */
+    clock_gettime(CLOCK_MONOTONIC, &clock->last);
+    clock->accumulator = 0;
+}
+
+int dronesim_clock_substeps(dronesim_clock_t *clock) {
+    /*
+     * Physics steps due since the previous call: the wall-clock time elapsed (CLOCK_MONOTONIC) is
+     * accumulated and consumed in whole steps of DRONESIM_STEP_SECONDS, the remainder is kept for the next
+     * frame. After a stall, at most PHYSICS_MAX_SUBSTEPS steps are run and the rest of the time is dropped.
+     * @return Number of steps to run in this frame.
+    */
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    clock->accumulator += (double)(now.tv_sec - clock->last.tv_sec) +
+        (double)(now.tv_nsec - clock->last.tv_nsec) / 1e9;
+    clock->last = now;
+    int substeps = (int)(clock->accumulator / DRONESIM_STEP_SECONDS);
+    if (substeps > PHYSICS_MAX_SUBSTEPS) {
+        substeps = PHYSICS_MAX_SUBSTEPS;
+        clock->accumulator = 0;
+    } else {
+        clock->accumulator -= substeps * DRONESIM_STEP_SECONDS;
+    }
+    return substeps;
+}
@@ -0,0 +1,335 @@
+//
+// Created by Gian Marco Balia
+//
+// src/dronesim_batch.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "dronesim.h"
+#include "dronesim_batch.h"
+
+struct dronesim_pool {
+    int num_threads;                        // * Worker threads plus the caller of dronesim_batch_step
+    pthread_t *threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;               // * Incremented for every step
+    int pending;                            // * Threads still working on the current step
+    int playing;                            // * Environments still playing after the current step
+    int stop;
+    dronesim_batch_t *batch;
+    const char *keys;
+    int substeps;
+};
+
+typedef struct {
+    dronesim_pool_t *pool;
+    int index;
+} worker_arg_t;
+
+static void *aligned_array(const size_t count, const size_t size) {
+    // * Arrays start on a cache line and are padded to a whole number of lines
+    const size_t bytes = (count * size + DRONESIM_BATCH_ALIGN - 1) / DRONESIM_BATCH_ALIGN * DRONESIM_BATCH_ALIGN;
+    void *array = aligned_alloc(DRONESIM_BATCH_ALIGN, bytes);
+    if (array != NULL) memset(array, 0, bytes);
+    return array;
+}
+
+static int step_block(dronesim_batch_t *batch, const char *keys, const int substeps, const int begin,
+    const int end) {
+    /*
+     * Step the environments [begin, end), at most DRONESIM_BATCH_BLOCK of them.
+     * @return Number of environments still playing.
+    */
+    double *restrict x_prev = batch->x_prev + begin, *restrict y_prev = batch->y_prev + begin;
+    double *restrict x = batch->x + begin, *restrict y = batch->y + begin;
+    double Fx[DRONESIM_BATCH_BLOCK], Fy[DRONESIM_BATCH_BLOCK];
+    double user_x[DRONESIM_BATCH_BLOCK], user_y[DRONESIM_BATCH_BLOCK];
+    double start_x[DRONESIM_BATCH_BLOCK], start_y[DRONESIM_BATCH_BLOCK];
+    const int n = end - begin;
+    const double h = DRONESIM_STEP_TIME;
+
+    // * Commands: one key per environment
+    for (int i = begin; i < end; i++) {
+        if (keys != NULL && keys[i] != '\0' && batch->outcome[i] == DRONESIM_PLAYING) {
+            int force[2] = {batch->force_x[i], batch->force_y[i]};
+            dronesim_command(force, keys[i]);
+            batch->force_x[i] = force[0];
+            batch->force_y[i] = force[1];
+        }
+        user_x[i - begin] = (double)batch->force_x[i]/10;
+        user_y[i - begin] = (double)batch->force_y[i]/10;
+        start_x[i - begin] = x[i - begin];
+        start_y[i - begin] = y[i - begin];
+    }
+    for (int step = 0; step < substeps; step++) {
+        // * Force of the map: one field lookup per environment
+        for (int k = 0; k < n; k++) {
+            force_field_sample(&batch->field[begin + k], x[k], y[k], &Fx[k], &Fy[k]);
+        }
+        // * Equations of motion, the same as dronesim_physics: a branch-free loop over contiguous arrays
+        for (int k = 0; k < n; k++) {
+            const double fx = Fx[k] + user_x[k];
+            const double fy = Fy[k] + user_y[k];
+            double xn = (h*h*fx - DRONE_MASS*x_prev[k] + (2*DRONE_MASS + DAMPING*h)*x[k]) / (DRONE_MASS + DAMPING*h);
+            double yn = (h*h*fy - DRONE_MASS*y_prev[k] + (2*DRONE_MASS + DAMPING*h)*y[k]) / (DRONE_MASS + DAMPING*h);
+            xn = xn < 3 ? 3 : xn;
+            xn = xn > GAME_WIDTH - 3 ? GAME_WIDTH - 3 : xn;
+            yn = yn < 3 ? 3 : yn;
+            yn = yn > GAME_HEIGHT - 3 ? GAME_HEIGHT - 3 : yn;
+            // * Environments that are over do not move
+            const int moving = batch->outcome[begin + k] == DRONESIM_PLAYING;
+            x_prev[k] = moving ? x[k] : x_prev[k];
+            y_prev[k] = moving ? y[k] : y_prev[k];
+            x[k] = moving ? xn : x[k];
+            y[k] = moving ? yn : y[k];
+        }
+    }
+    // * Targets, score and outcome, the same as dronesim_apply_move
+    int playing = 0;
+    for (int i = begin; i < end; i++) {
+        if (batch->outcome[i] != DRONESIM_PLAYING) continue;
+        bitgrid_t *cells = &batch->cells[i];
+        const int prev_col = dronesim_cell(start_x[i - begin]), prev_row = dronesim_cell(start_y[i - begin]);
+        const int col = dronesim_cell(x[i - begin]), row = dronesim_cell(y[i - begin]);
+        const int removed = dronesim_remove_targets_on_path(NULL, cells, prev_col, prev_row, col, row);
+        int changed = removed;
+        batch->count_targets[i] -= removed;
+        batch->distance_traveled[i] += abs(col - prev_col) + abs(row - prev_row);
+        batch->steps[i] += substeps;
+        batch->elapsed_time[i] = (double)batch->steps[i] * DRONESIM_STEP_SECONDS;
+        batch->outcome[i] = dronesim_score(&batch->score[i], batch->distance_traveled[i], batch->elapsed_time[i],
+            batch->count_obstacles[i], batch->count_targets[i], substeps);
+        // * The drone leaves the cell it was in: it is cleaned before the next frame (a target there was already
+        // * taken, and counted, by the path, which starts from this cell)
+        const int left = bitgrid_index(prev_col, prev_row);
+        if (bitgrid_test(cells->obstacles, left)) {
+            bitgrid_reset(cells->obstacles, left);
+            changed++;
+        }
+        if (changed > 0) {
+            force_field_update(&batch->field[i], cells);
+        }
+        if (keys != NULL && keys[i] == 'q' && batch->outcome[i] == DRONESIM_PLAYING) {
+            batch->outcome[i] = DRONESIM_QUIT;
+        }
+        batch->frame[i]++;
+        playing += batch->outcome[i] == DRONESIM_PLAYING;
+    }
+    return playing;
+}
+
+static int step_range(dronesim_batch_t *batch, const char *keys, const int substeps, const int worker,
+    const int num_workers) {
+    // * Contiguous share of the environments of a worker, cut at multiples of 16 (whole cache lines)
+    const int lines = (batch->count + 15) / 16;
+    const int begin = (int)((long)lines * worker / num_workers) * 16;
+    int end = (int)((long)lines * (worker + 1) / num_workers) * 16;
+    end = end > batch->count ? batch->count : end;
+    int playing = 0;
+    for (int i = begin; i < end; i += DRONESIM_BATCH_BLOCK) {
+        playing += step_block(batch, keys, substeps, i, i + DRONESIM_BATCH_BLOCK < end ? i + DRONESIM_BATCH_BLOCK : end);
+    }
+    return playing;
+}
+
+static void *worker_main(void *arg) {
+    dronesim_pool_t *pool = ((worker_arg_t *)arg)->pool;
+    const int index = ((worker_arg_t *)arg)->index;
+    free(arg);
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->mutex);
+    while (1) {
+        while (pool->generation == seen && !pool->stop) {
+            pthread_cond_wait(&pool->start, &pool->mutex);
+        }
+        if (pool->stop) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+        const int playing = step_range(pool->batch, pool->keys, pool->substeps, index, pool->num_threads);
+        pthread_mutex_lock(&pool->mutex);
+        pool->playing += playing;
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+dronesim_batch_t *dronesim_batch_create(const int count, int num_threads) {
+    /*
+     * Allocate a batch of environments and start its threads. The environments must be reset with
+     * dronesim_batch_reset before they are stepped.
+     * @param count Number of environments.
+     * @param num_threads Threads stepping the batch (the caller included), 0 for one per online CPU.
+     * @return The batch, NULL on failure.
+    */
+    if (count <= 0) return NULL;
+    if (num_threads <= 0) {
+        num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    // * No point in more threads than cache lines of environments
+    if (num_threads > (count + 15) / 16) num_threads = (count + 15) / 16;
+    if (num_threads < 1) num_threads = 1;
+
+    dronesim_batch_t *batch = calloc(1, sizeof(dronesim_batch_t));
+    dronesim_pool_t *pool = calloc(1, sizeof(dronesim_pool_t));
+    if (batch == NULL || pool == NULL) {
+        perror("calloc batch");
+        free(batch);
+        free(pool);
+        return NULL;
+    }
+    batch->count = count;
+    batch->pool = pool;
+    batch->x_prev = aligned_array(count, sizeof(double));
+    batch->y_prev = aligned_array(count, sizeof(double));
+    batch->x = aligned_array(count, sizeof(double));
+    batch->y = aligned_array(count, sizeof(double));
+    batch->force_x = aligned_array(count, sizeof(int));
+    batch->force_y = aligned_array(count, sizeof(int));
+    batch->score = aligned_array(count, sizeof(int));
+    batch->distance_traveled = aligned_array(count, sizeof(int));
+    batch->count_obstacles = aligned_array(count, sizeof(int));
+    batch->count_targets = aligned_array(count, sizeof(int));
+    batch->outcome = aligned_array(count, sizeof(int));
+    batch->steps = aligned_array(count, sizeof(long));
+    batch->frame = aligned_array(count, sizeof(long));
+    batch->elapsed_time = aligned_array(count, sizeof(double));
+    batch->cells = aligned_array(count, sizeof(bitgrid_t));
+    batch->field = aligned_array(count, sizeof(force_field_t));
+    pool->threads = calloc((size_t)num_threads, sizeof(pthread_t));
+    if (!batch->x_prev || !batch->y_prev || !batch->x || !batch->y || !batch->force_x || !batch->force_y ||
+        !batch->score || !batch->distance_traveled || !batch->count_obstacles || !batch->count_targets ||
+        !batch->outcome || !batch->steps || !batch->frame || !batch->elapsed_time || !batch->cells || !batch->field ||
+        !pool->threads) {
+        perror("aligned_alloc batch");
+        dronesim_batch_destroy(batch);
+        return NULL;
+    }
+    // * Environments are not playing until they get a map
+    for (int i = 0; i < count; i++) {
+        batch->outcome[i] = DRONESIM_QUIT;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->num_threads = 1;
+    // * Thread 0 is the caller of dronesim_batch_step, the others wait for a step in worker_main
+    for (int t = 1; t < num_threads; t++) {
+        worker_arg_t *arg = malloc(sizeof(worker_arg_t));
+        if (arg == NULL) break;
+        arg->pool = pool;
+        arg->index = t;
+        if (pthread_create(&pool->threads[t], NULL, worker_main, arg) != 0) {
+            perror("pthread_create batch");
+            free(arg);
+            break;
+        }
+        pool->num_threads++;
+    }
+    return batch;
+}
+
+void dronesim_batch_destroy(dronesim_batch_t *batch) {
+    /*
+     * Stop the threads of a batch and free it.
+    */
+    if (batch == NULL) return;
+    dronesim_pool_t *pool = batch->pool;
+    if (pool->num_threads > 0) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->stop = 1;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->mutex);
+        for (int t = 1; t < pool->num_threads; t++) {
+            pthread_join(pool->threads[t], NULL);
+        }
+        pthread_mutex_destroy(&pool->mutex);
+        pthread_cond_destroy(&pool->start);
+        pthread_cond_destroy(&pool->done);
+    }
+    free(pool->threads);
+    free(pool);
+    free(batch->x_prev);
+    free(batch->y_prev);
+    free(batch->x);
+    free(batch->y);
+    free(batch->force_x);
+    free(batch->force_y);
+    free(batch->score);
+    free(batch->distance_traveled);
+    free(batch->count_obstacles);
+    free(batch->count_targets);
+    free(batch->outcome);
+    free(batch->steps);
+    free(batch->frame);
+    free(batch->elapsed_time);
+    free(batch->cells);
+    free(batch->field);
+    free(batch);
+}
+
+void dronesim_batch_reset(dronesim_batch_t *batch, const int env, const char grid[GAME_HEIGHT][GAME_WIDTH]) {
+    /*
+     * Start a new game in one environment, as dronesim_reset. Not to be called during a step.
+     * @param batch The batch.
+     * @param env Index of the environment.
+     * @param grid The map: anything but obstacles and targets is discarded.
+    */
+    bitgrid_t *cells = &batch->cells[env];
+    bitgrid_from_chars(cells, grid);
+    // * The drone starts in the center: whatever is there is taken
+    bitgrid_reset(cells->obstacles, bitgrid_index(GAME_WIDTH / 2, GAME_HEIGHT / 2));
+    bitgrid_reset(cells->targets, bitgrid_index(GAME_WIDTH / 2, GAME_HEIGHT / 2));
+    batch->x_prev[env] = batch->x[env] = GAME_WIDTH / 2;
+    batch->y_prev[env] = batch->y[env] = GAME_HEIGHT / 2;
+    batch->force_x[env] = 0;
+    batch->force_y[env] = 0;
+    batch->score[env] = MAX_SCORE;
+    batch->distance_traveled[env] = 0;
+    batch->count_obstacles[env] = bitgrid_count(cells->obstacles);
+    batch->count_targets[env] = bitgrid_count(cells->targets);
+    batch->elapsed_time[env] = 0;
+    batch->steps[env] = 0;
+    batch->frame[env] = 0;
+    batch->outcome[env] = DRONESIM_PLAYING;
+    force_field_build(&batch->field[env], cells);
+}
+
+int dronesim_batch_step(dronesim_batch_t *batch, const char *keys, const int substeps) {
+    /*
+     * Run a frame of every environment still playing; the others are left as they are.
+     * @param batch The batch.
+     * @param keys Key pressed in each environment ('\0' for none), NULL for no key at all.
+     * @param substeps Physics steps of the frame (PHYSICS_SUBSTEPS at FRAME_RATE).
+     * @return Number of environments still playing.
+    */
+    dronesim_pool_t *pool = batch->pool;
+    if (pool->num_threads == 1) {
+        return step_range(batch, keys, substeps, 0, 1);
+    }
+    pthread_mutex_lock(&pool->mutex);
+    pool->batch = batch;
+    pool->keys = keys;
+    pool->substeps = substeps;
+    pool->playing = 0;
+    pool->pending = pool->num_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+    const int playing = step_range(batch, keys, substeps, 0, pool->num_threads);
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+    pool->playing += playing;
+    const int total = pool->playing;
+    pthread_mutex_unlock(&pool->mutex);
+    return total;
+}
@@ -0,0 +1,141 @@
+//
+// Created by Gian Marco Balia
+//
+// src/dronesim_headless.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "macros.h"
+#include "dronesim.h"
+
+#ifndef AUTOPILOT_GAIN
+#define AUTOPILOT_GAIN 2                    // * Cells of distance per cell/frame of wanted velocity
+#endif
+#ifndef AUTOPILOT_KV
+#define AUTOPILOT_KV 2                      // * Force steps per cell/frame of velocity error
+#endif
+#ifndef AUTOPILOT_MAX_FORCE
+#define AUTOPILOT_MAX_FORCE 2
+#endif
+
+static const char *outcome_names[] = {"timeout", "won", "lost", "quit"};
+
+static unsigned int next_random(unsigned int *seed) {
+    // * xorshift32: reproducible maps for a given seed, independent of the libc rand()
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+static void random_map(char grid[GAME_HEIGHT][GAME_WIDTH], unsigned int *seed) {
+    /*
+     * Generate a map as the Obstacles and Targets processes do: obstacles on 0.2% of the cells and targets
+     * from '9' to '0', never in the center where the drone starts.
+    */
+    memset(grid, ' ', GAME_HEIGHT * GAME_WIDTH);
+    int total_obstacles = (int)(GAME_HEIGHT * GAME_WIDTH * 0.002);
+    char num_target = '9';
+    while (total_obstacles > 0 || num_target >= '0') {
+        const int x = (int)(next_random(seed) % (GAME_WIDTH - 2)) + 1;
+        const int y = (int)(next_random(seed) % (GAME_HEIGHT - 2)) + 1;
+        if (grid[y][x] != ' ' || (x == GAME_WIDTH / 2 && y == GAME_HEIGHT / 2)) continue;
+        if (total_obstacles > 0) {
+            grid[y][x] = 'o';
+            total_obstacles--;
+        } else {
+            grid[y][x] = num_target--;
+        }
+    }
+}
+
+typedef struct {
+    int count;
+    int x[10], y[10];                       // * Targets of the map, checked against the cells when used
+} target_list_t;
+
+static void list_targets(const dronesim_state_t *state, target_list_t *targets) {
+    targets->count = 0;
+    const uint64_t *bits = state->cells.targets;
+    for (int i = bitgrid_next(bits, 0); i >= 0 && targets->count < 10; i = bitgrid_next(bits, i + 1)) {
+        targets->x[targets->count] = i % GAME_WIDTH;
+        targets->y[targets->count] = i / GAME_WIDTH;
+        targets->count++;
+    }
+}
+
+static char autopilot(const dronesim_state_t *state, const target_list_t *targets) {
+    /*
+     * Simple controller: steer the user force toward the nearest target, damped by the drone velocity.
+     * @return The key to press in this frame, '\0' for none.
+    */
+    static const char keys[3][3] = {{'w', 'e', 'r'}, {'s', '\0', 'f'}, {'x', 'c', 'v'}};
+    const int x = dronesim_cell(state->drone_pos[2]), y = dronesim_cell(state->drone_pos[3]);
+    int best = -1, tx = x, ty = y;
+    for (int i = 0; i < targets->count; i++) {
+        if (bitgrid_cell(&state->cells, targets->x[i], targets->y[i]) != CELL_TARGET) continue;
+        const int d = abs(targets->x[i] - x) + abs(targets->y[i] - y);
+        if (best == -1 || d < best) {
+            best = d;
+            tx = targets->x[i];
+            ty = targets->y[i];
+        }
+    }
+    // * Velocity in cells per frame
+    const double vx = (state->drone_pos[2] - state->drone_pos[0]) * PHYSICS_SUBSTEPS;
+    const double vy = (state->drone_pos[3] - state->drone_pos[1]) * PHYSICS_SUBSTEPS;
+    int want_x = (int)(AUTOPILOT_KV * ((double)(tx - x) / AUTOPILOT_GAIN - vx));
+    int want_y = (int)(AUTOPILOT_KV * ((double)(ty - y) / AUTOPILOT_GAIN - vy));
+    want_x = want_x > AUTOPILOT_MAX_FORCE ? AUTOPILOT_MAX_FORCE : (want_x < -AUTOPILOT_MAX_FORCE ? -AUTOPILOT_MAX_FORCE : want_x);
+    want_y = want_y > AUTOPILOT_MAX_FORCE ? AUTOPILOT_MAX_FORCE : (want_y < -AUTOPILOT_MAX_FORCE ? -AUTOPILOT_MAX_FORCE : want_y);
+    const int step_x = (want_x > state->drone_force[0]) - (want_x < state->drone_force[0]);
+    const int step_y = (want_y > state->drone_force[1]) - (want_y < state->drone_force[1]);
+    return keys[step_y + 1][step_x + 1];
+}
+
+int main(const int argc, char *argv[]) {
+    /*
+     * Headless games: no terminal, no pipes, no DDS, as fast as the CPU allows.
+     * @param argv[1]: Number of games (default 1000)
+     * @param argv[2]: Seed (default 1)
+     * @param argv[3]: Maximum frames per game (default 60 s of game)
+     * Prints one CSV line per game on stdout and a summary on stderr.
+    */
+    const long games = argc > 1 ? atol(argv[1]) : 1000;
+    unsigned int seed = argc > 2 ? (unsigned int)atol(argv[2]) : 1;
+    const long max_frames = argc > 3 ? atol(argv[3]) : (long)(60 * FRAME_RATE);
+    if (games <= 0 || max_frames <= 0) {
+        fprintf(stderr, "Usage: %s [games] [seed] [max_frames]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (seed == 0) seed = 1;
+
+    static dronesim_state_t state;
+    static char grid[GAME_HEIGHT][GAME_WIDTH];
+    long outcomes[4] = {0, 0, 0, 0};
+    long total_frames = 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    printf("game,outcome,frames,score,targets_left\n");
+    for (long g = 0; g < games; g++) {
+        random_map(grid, &seed);
+        dronesim_reset(&state, grid);
+        target_list_t targets;
+        list_targets(&state, &targets);
+        dronesim_input_t input = {'\0', PHYSICS_SUBSTEPS};
+        while (state.outcome == DRONESIM_PLAYING && state.frame < max_frames) {
+            input.key = autopilot(&state, &targets);
+            dronesim_step(&state, &input);
+        }
+        outcomes[state.outcome]++;
+        total_frames += state.frame;
+        printf("%ld,%s,%ld,%d,%d\n", g, outcome_names[state.outcome], state.frame, state.score, state.count_targets);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    const double seconds = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    fprintf(stderr, "%ld games (%ld won, %ld lost, %ld timeout) in %.3f s: %.0f games/s, %.0f frames/s\n",
+        games, outcomes[DRONESIM_WON], outcomes[DRONESIM_LOST], outcomes[DRONESIM_PLAYING], seconds,
+        games / seconds, total_frames / seconds);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+//
+// Created by Gian Marco Balia
+//
+// src/event_loop.c
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include "event_loop.h"
+
+int event_loop_open(event_loop_t *loop, const double frame_rate) {
+    /*
+     * Create the epoll instance, the frame tick and the notification eventfd, both already watched.
+     * @param frame_rate Frame ticks per second.
+     * @return 0 on success, -1 on failure.
+    */
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    loop->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    loop->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (loop->epoll_fd == -1 || loop->timer_fd == -1 || loop->notify_fd == -1) {
+        perror("event loop");
+        event_loop_close(loop);
+        return -1;
+    }
+    const long period_ns = (long)(1e9 / frame_rate);
+    struct itimerspec tick = {
+        .it_interval = {period_ns / 1000000000L, period_ns % 1000000000L},
+        .it_value = {period_ns / 1000000000L, period_ns % 1000000000L},
+    };
+    if (timerfd_settime(loop->timer_fd, 0, &tick, NULL) == -1 ||
+        event_loop_add(loop, loop->timer_fd, EPOLLIN) == -1 ||
+        event_loop_add(loop, loop->notify_fd, EPOLLIN) == -1) {
+        perror("event loop");
+        event_loop_close(loop);
+        return -1;
+    }
+    return 0;
+}
+
+void event_loop_close(event_loop_t *loop) {
+    if (loop->epoll_fd != -1) close(loop->epoll_fd);
+    if (loop->timer_fd != -1) close(loop->timer_fd);
+    if (loop->notify_fd != -1) close(loop->notify_fd);
+    loop->epoll_fd = loop->timer_fd = loop->notify_fd = -1;
+}
+
+int event_loop_add(event_loop_t *loop, const int fd, const uint32_t events) {
+    /*
+     * Watch a file descriptor.
+     * @param events EPOLLIN, EPOLLOUT, ... (errors and hang-ups are always reported).
+     * @return 0 on success, -1 on failure.
+    */
+    struct epoll_event event = {.events = events, .data = {.fd = fd}};
+    return epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+int event_loop_remove(event_loop_t *loop, const int fd) {
+    return epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+int event_loop_wait(event_loop_t *loop, struct epoll_event *events, const int max_events) {
+    /*
+     * Wait until at least one file descriptor is ready. The frame tick bounds the wait.
+     * @return Number of events, 0 if interrupted by a signal, -1 on failure.
+    */
+    const int ready = epoll_wait(loop->epoll_fd, events, max_events, -1);
+    if (ready == -1 && errno == EINTR) return 0;
+    return ready;
+}
+
+uint64_t event_loop_ticks(event_loop_t *loop) {
+    /*
+     * Consume the frame tick.
+     * @return Ticks elapsed since the last call (more than one if frames were missed).
+    */
+    uint64_t ticks = 0;
+    if (read(loop->timer_fd, &ticks, sizeof(ticks)) != sizeof(ticks)) return 0;
+    return ticks;
+}
+
+void event_loop_notify(const int notify_fd) {
+    /*
+     * Wake the loop from any thread. Notifications are coalesced until the loop consumes them.
+    */
+    const uint64_t one = 1;
+    if (write(notify_fd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+        perror("event loop notify");
+    }
+}
+
+uint64_t event_loop_notified(event_loop_t *loop) {
+    /*
+     * Consume the notifications.
+     * @return Number of notifications since the last call.
+    */
+    uint64_t count = 0;
+    if (read(loop->notify_fd, &count, sizeof(count)) != sizeof(count)) return 0;
+    return count;
+}
@@ -0,0 +1,75 @@
+//
+// Created by Gian Marco Balia
+//
+// src/force_field.c
+#include <string.h>
+#include "force_field.h"
+#include "force_kernel.h"
+
+static void splat_cell(force_field_t *field, const force_kernel_t *kernel, const int index, const double sign) {
+    // * Add (sign = 1) or remove (sign = -1) the contribution of one cell to its influence neighbourhood
+    const int row = index / GAME_WIDTH, col = index % GAME_WIDTH;
+    const int min_row = row - FORCE_KERNEL_RADIUS < 0 ? 0 : row - FORCE_KERNEL_RADIUS;
+    const int max_row = row + FORCE_KERNEL_RADIUS >= GAME_HEIGHT ? GAME_HEIGHT - 1 : row + FORCE_KERNEL_RADIUS;
+    const int min_col = col - FORCE_KERNEL_RADIUS < 0 ? 0 : col - FORCE_KERNEL_RADIUS;
+    const int max_col = col + FORCE_KERNEL_RADIUS >= GAME_WIDTH ? GAME_WIDTH - 1 : col + FORCE_KERNEL_RADIUS;
+    for (int r = min_row; r <= max_row; r++) {
+        const double *kx = kernel->fx[r - row + FORCE_KERNEL_RADIUS];
+        const double *ky = kernel->fy[r - row + FORCE_KERNEL_RADIUS];
+        for (int c = min_col; c <= max_col; c++) {
+            field->fx[r][c] += sign * kx[c - col + FORCE_KERNEL_RADIUS];
+            field->fy[r][c] += sign * ky[c - col + FORCE_KERNEL_RADIUS];
+        }
+    }
+}
+
+void force_field_build(force_field_t *field, const bitgrid_t *cells) {
+    /*
+     * Compute the whole field from scratch.
+     * @param field The field to build.
+     * @param cells The game map.
+    */
+    memset(field->fx, 0, sizeof(field->fx));
+    memset(field->fy, 0, sizeof(field->fy));
+    field->cells = *cells;
+    for (int i = bitgrid_next(cells->obstacles, 0); i >= 0; i = bitgrid_next(cells->obstacles, i + 1)) {
+        splat_cell(field, &force_kernel_obstacle, i, 1.0);
+    }
+    for (int i = bitgrid_next(cells->targets, 0); i >= 0; i = bitgrid_next(cells->targets, i + 1)) {
+        splat_cell(field, &force_kernel_target, i, 1.0);
+    }
+}
+
+int force_field_update(force_field_t *field, const bitgrid_t *cells) {
+    /*
+     * Bring the field up to date with a new version of the map, touching only the neighbourhood of the
+     * changed cells. A new map (many changed cells) is rebuilt from scratch instead.
+     * @return Number of changed cells.
+    */
+    int changed = 0;
+    for (int word = 0; word < BITGRID_WORDS; word++) {
+        changed += __builtin_popcountll((field->cells.obstacles[word] ^ cells->obstacles[word]) |
+            (field->cells.targets[word] ^ cells->targets[word]));
+    }
+    if (changed == 0) {
+        return 0;
+    }
+    if (changed > FORCE_FIELD_REBUILD_CELLS) {
+        force_field_build(field, cells);
+        return changed;
+    }
+    for (int word = 0; word < BITGRID_WORDS; word++) {
+        // * Cells that appeared add their kernel, cells that disappeared remove it
+        for (uint64_t diff = field->cells.obstacles[word] ^ cells->obstacles[word]; diff != 0; diff &= diff - 1) {
+            const int index = word * 64 + __builtin_ctzll(diff);
+            splat_cell(field, &force_kernel_obstacle, index, bitgrid_test(cells->obstacles, index) ? 1.0 : -1.0);
+        }
+        for (uint64_t diff = field->cells.targets[word] ^ cells->targets[word]; diff != 0; diff &= diff - 1) {
+            const int index = word * 64 + __builtin_ctzll(diff);
+            splat_cell(field, &force_kernel_target, index, bitgrid_test(cells->targets, index) ? 1.0 : -1.0);
+        }
+        field->cells.obstacles[word] = cells->obstacles[word];
+        field->cells.targets[word] = cells->targets[word];
+    }
+    return changed;
+}
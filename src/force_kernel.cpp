@@ -0,0 +1,69 @@
+//
+// Created by Gian Marco Balia
+//
+// src/force_kernel.cpp
+#include "force_kernel.h"
+
+static_assert(RHO_OBST <= FORCE_KERNEL_RADIUS + 1, "FORCE_KERNEL_RADIUS does not cover the obstacles' influence");
+static_assert(RHO_TRG <= FORCE_KERNEL_RADIUS + 1, "FORCE_KERNEL_RADIUS does not cover the targets' influence");
+
+namespace {
+
+constexpr double const_sqrt(const double value) {
+    // * Newton-Raphson iteration, until it stops improving
+    if (value <= 0.0) {
+        return 0.0;
+    }
+    double x = value > 1.0 ? value : 1.0;
+    for (int i = 0; i < 100; i++) {
+        const double next = 0.5 * (x + value / x);
+        if (next >= x) {
+            break;
+        }
+        x = next;
+    }
+    return x;
+}
+
+constexpr force_kernel_t make_obstacle_kernel() {
+    // * Repulsive force: ETA*(1/dist - 1/RHO_OBST)*d/dist^3, with dist clamped to MIN_RHO_OBST
+    force_kernel_t kernel{};
+    for (int dy = -FORCE_KERNEL_RADIUS; dy <= FORCE_KERNEL_RADIUS; dy++) {
+        for (int dx = -FORCE_KERNEL_RADIUS; dx <= FORCE_KERNEL_RADIUS; dx++) {
+            double dist = const_sqrt(static_cast<double>(dx * dx + dy * dy));
+            dist = dist < MIN_RHO_OBST ? MIN_RHO_OBST : dist;
+            if (dist < RHO_OBST) {
+                const double magnitude = ETA * (1 / dist - 1 / RHO_OBST) / (dist * dist * dist);
+                kernel.fx[dy + FORCE_KERNEL_RADIUS][dx + FORCE_KERNEL_RADIUS] = -magnitude * dx;
+                kernel.fy[dy + FORCE_KERNEL_RADIUS][dx + FORCE_KERNEL_RADIUS] = -magnitude * dy;
+            }
+        }
+    }
+    return kernel;
+}
+
+constexpr force_kernel_t make_target_kernel() {
+    // * Attractive force: EPSILON*d/dist, with dist clamped to MIN_RHO_TRG
+    force_kernel_t kernel{};
+    for (int dy = -FORCE_KERNEL_RADIUS; dy <= FORCE_KERNEL_RADIUS; dy++) {
+        for (int dx = -FORCE_KERNEL_RADIUS; dx <= FORCE_KERNEL_RADIUS; dx++) {
+            double dist = const_sqrt(static_cast<double>(dx * dx + dy * dy));
+            dist = dist < MIN_RHO_TRG ? MIN_RHO_TRG : dist;
+            if (dist < RHO_TRG) {
+                kernel.fx[dy + FORCE_KERNEL_RADIUS][dx + FORCE_KERNEL_RADIUS] = -EPSILON * dx / dist;
+                kernel.fy[dy + FORCE_KERNEL_RADIUS][dx + FORCE_KERNEL_RADIUS] = -EPSILON * dy / dist;
+            }
+        }
+    }
+    return kernel;
+}
+
+constexpr force_kernel_t obstacle_kernel = make_obstacle_kernel();
+constexpr force_kernel_t target_kernel = make_target_kernel();
+
+}
+
+extern "C" {
+const force_kernel_t force_kernel_obstacle = obstacle_kernel;
+const force_kernel_t force_kernel_target = target_kernel;
+}
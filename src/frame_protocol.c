@@ -0,0 +1,142 @@
+//
+// Created by Gian Marco Balia
+//
+// src/frame_protocol.c
+#include <errno.h>
+#include <unistd.h>
+#include "frame_protocol.h"
+
+static int check_header(const frame_header_t *header, uint8_t type) {
+    if (header->magic != FRAME_MAGIC || header->version != FRAME_VERSION || header->type != type) {
+        errno = EPROTO;
+        return -1;
+    }
+    return 0;
+}
+
+int frame_read_full(const int fd, void *buf, size_t size) {
+    /*
+     * Read exactly size bytes, retrying on partial reads and interruptions.
+     * @return 0 on success, -1 on failure or end of file.
+    */
+    char *p = buf;
+    while (size > 0) {
+        const ssize_t n = read(fd, p, size);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            errno = EPIPE;
+            return -1;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+int frame_write_full(const int fd, const void *buf, size_t size) {
+    /*
+     * Write exactly size bytes, retrying on partial writes and interruptions.
+     * @return 0 on success, -1 on failure.
+    */
+    const char *p = buf;
+    while (size > 0) {
+        const ssize_t n = write(fd, p, size);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+int frame_send_state(const int fd, const uint32_t sequence, const uint8_t flags, const frame_state_t *state) {
+    /*
+     * Send the drone state to Dynamics.
+     * @param sequence Frame sequence number, echoed by the reply.
+     * @param flags FRAME_FLAG_RESET to move the drone to the position of the state, 0 otherwise.
+     * @return 0 on success, -1 on failure.
+    */
+    struct __attribute__((packed)) {
+        frame_header_t header;
+        frame_state_t state;
+    } msg = {
+        .header = {
+            .magic = FRAME_MAGIC,
+            .version = FRAME_VERSION,
+            .type = FRAME_TYPE_STATE,
+            .flags = flags,
+            .sequence = sequence,
+            .payload_size = sizeof(*state),
+        },
+        .state = *state,
+    };
+    return frame_write_full(fd, &msg, sizeof(msg));
+}
+
+int frame_recv_state(const int fd, uint32_t *sequence, uint8_t *flags, frame_state_t *state) {
+    /*
+     * Receive the drone state from the Blackboard.
+     * @return 0 on success, -1 on failure (errno is EPROTO for malformed messages).
+    */
+    frame_header_t header;
+    if (frame_read_full(fd, &header, sizeof(header)) == -1 || check_header(&header, FRAME_TYPE_STATE) == -1) {
+        return -1;
+    }
+    if (header.payload_size != sizeof(*state)) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (frame_read_full(fd, state, sizeof(*state)) == -1) {
+        return -1;
+    }
+    *sequence = header.sequence;
+    *flags = header.flags;
+    return 0;
+}
+
+int frame_send_reply(const int fd, const uint32_t sequence, const frame_reply_t *reply) {
+    /*
+     * Send the new drone position to the Blackboard.
+     * @return 0 on success, -1 on failure.
+    */
+    struct __attribute__((packed)) {
+        frame_header_t header;
+        frame_reply_t reply;
+    } msg = {
+        .header = {
+            .magic = FRAME_MAGIC,
+            .version = FRAME_VERSION,
+            .type = FRAME_TYPE_REPLY,
+            .flags = 0,
+            .sequence = sequence,
+            .payload_size = sizeof(*reply),
+        },
+        .reply = *reply,
+    };
+    return frame_write_full(fd, &msg, sizeof(msg));
+}
+
+int frame_recv_reply(const int fd, uint32_t *sequence, frame_reply_t *reply) {
+    /*
+     * Receive the new drone position from Dynamics.
+     * @return 0 on success, -1 on failure (errno is EPROTO for malformed messages).
+    */
+    frame_header_t header;
+    if (frame_read_full(fd, &header, sizeof(header)) == -1 || check_header(&header, FRAME_TYPE_REPLY) == -1) {
+        return -1;
+    }
+    if (header.payload_size != sizeof(*reply)) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (frame_read_full(fd, reply, sizeof(*reply)) == -1) {
+        return -1;
+    }
+    *sequence = header.sequence;
+    return 0;
+}
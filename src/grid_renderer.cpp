@@ -0,0 +1,112 @@
+//
+// Created by Gian Marco Balia
+//
+// src/grid_renderer.cpp
+#include <string.h>
+#include "bitgrid.h"
+#include "grid_renderer.h"
+
+GridRenderer::GridRenderer()
+    : height_(0)
+    , width_(0)
+    , repaint_(true)
+    , drone_x_(-1)
+    , drone_y_(-1)
+{
+    memset(grid_, ' ', sizeof(grid_));
+}
+
+void GridRenderer::invalidate() {
+    /*
+     * The window was erased or recreated: repaint everything at the next frame.
+    */
+    repaint_ = true;
+}
+
+chtype GridRenderer::compute_cell(const int screen_row, const int screen_col) const {
+    /*
+     * Content of a window cell from the shadow grid and drone.
+     * @return The character with its color.
+    */
+    if (drone_x_ * width_ / GAME_WIDTH == screen_col && drone_y_ * height_ / GAME_HEIGHT == screen_row) {
+        return '+' | COLOR_PAIR(1);         // * BLUE for drone
+    }
+    // * Grid cells shown in this window cell: rows and columns whose scaled coordinate falls here
+    int first_row = (screen_row * GAME_HEIGHT + height_ - 1) / height_;
+    int first_col = (screen_col * GAME_WIDTH + width_ - 1) / width_;
+    first_row = first_row < 1 ? 1 : first_row;
+    first_col = first_col < 1 ? 1 : first_col;
+    chtype content = ' ';
+    for (int row = first_row; row < GAME_HEIGHT - 1 && row * height_ / GAME_HEIGHT == screen_row; row++) {
+        for (int col = first_col; col < GAME_WIDTH - 1 && col * width_ / GAME_WIDTH == screen_col; col++) {
+            const char cell = grid_[row][col];
+            switch (BITGRID_CELL_CLASS(cell)) {
+                case CELL_OBSTACLE: content = 'o' | COLOR_PAIR(3); break;  // * YELLOW for obstacles
+                case CELL_TARGET: content = (chtype)cell | COLOR_PAIR(2); break;  // * GREEN for targets
+                default: break;
+            }
+        }
+    }
+    return content;
+}
+
+void GridRenderer::mark_cell(const int row, const int col) {
+    // * Window cell of a grid cell (or of the drone) to recompute
+    dirty_.push_back((row * height_ / GAME_HEIGHT) * width_ + col * width_ / GAME_WIDTH);
+}
+
+int GridRenderer::draw(WINDOW *win, const char grid[GAME_HEIGHT][GAME_WIDTH], const int drone_x,
+    const int drone_y) {
+    /*
+     * Bring the window up to date with the grid and the drone, writing only the cells that changed.
+     * @param win The game window (the caller refreshes it).
+     * @param grid The game map.
+     * @param drone_x, drone_y Drone cell.
+     * @return Number of window cells written.
+    */
+    int height = 0, width = 0;
+    getmaxyx(win, height, width);
+    dirty_.clear();
+    if (repaint_ || height != height_ || width != width_) {
+        // * Full repaint: the window starts blank and every non-empty cell is written
+        height_ = height;
+        width_ = width;
+        werase(win);
+        screen_.assign((size_t)height_ * width_, ' ');
+        memcpy(grid_, grid, sizeof(grid_));
+        drone_x_ = drone_x;
+        drone_y_ = drone_y;
+        for (int row = 1; row < GAME_HEIGHT - 1; row++) {
+            for (int col = 1; col < GAME_WIDTH - 1; col++) {
+                if (grid_[row][col] != ' ') mark_cell(row, col);
+            }
+        }
+        mark_cell(drone_y_, drone_x_);
+        repaint_ = false;
+    } else {
+        // * Only the rows that differ from the shadow are scanned
+        for (int row = 1; row < GAME_HEIGHT - 1; row++) {
+            if (memcmp(grid_[row], grid[row], GAME_WIDTH) == 0) continue;
+            for (int col = 1; col < GAME_WIDTH - 1; col++) {
+                if (grid_[row][col] != grid[row][col]) mark_cell(row, col);
+            }
+            memcpy(grid_[row], grid[row], GAME_WIDTH);
+        }
+        if (drone_x != drone_x_ || drone_y != drone_y_) {
+            mark_cell(drone_y_, drone_x_);
+            drone_x_ = drone_x;
+            drone_y_ = drone_y;
+            mark_cell(drone_y_, drone_x_);
+        }
+    }
+    int written = 0;
+    for (const int index : dirty_) {
+        if (index < 0 || index >= (int)screen_.size()) continue;
+        const chtype content = compute_cell(index / width_, index % width_);
+        if (content == screen_[index]) continue;
+        mvwaddch(win, index / width_, index % width_, content);
+        screen_[index] = content;
+        written++;
+    }
+    return written;
+}
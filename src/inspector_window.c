@@ -5,16 +5,27 @@
 
 #include <ncurses.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/fcntl.h>
 #include <signal.h>
 #include <errno.h>
 
 #include "macros.h"
+#include "telemetry_shm.h"
+
+#define INSPECTOR_REFRESH_RATE 30.0         // * Repaints per second, at most
+#define INSPECTOR_LINES 16                  // * Lines of the left_box kept to compare
+#define INSPECTOR_LINE_LENGTH 64
 
 static volatile sig_atomic_t keep_running = 1;
 
+// * Keys of the keypad, as drawn in the right_box
+static const char keypad_keys[3][3] = {{'w', 'e', 'r'}, {'s', 'd', 'f'}, {'x', 'c', 'v'}};
+
 void signal_close(int signum);
+int paint_line(WINDOW *win, char painted[INSPECTOR_LINES][INSPECTOR_LINE_LENGTH], int row, const char *text);
+void paint_key(WINDOW *win, char key, bool highlighted);
 
 int main() {
     // * Initialize ncurses
@@ -42,150 +53,76 @@ int main() {
     box(left_box, 0, 0);
     box(right_box, 0, 0);
     // * Initialise left_box
-    mvwprintw(left_box, 1, 1, "Drone Position: N/A");
-    mvwprintw(left_box, 2, 1, "Velocity: N/A");
-    mvwprintw(left_box, 3, 1, "Force: N/A");
-    wrefresh(left_box);
-    // * Draw the keypad
-    // * - 1st rop: [w]  [e]  [r]
-    // * - 2nd rop: [s]  [d]  [f]
-    // * - 3rd row: [x]  [c]  [v]
-    int rH, rW;
-    getmaxyx(right_box, rH, rW);
-    int inner_width = rW - 2;
-    int inner_height = rH - 2;
-    int total_length = 13;
-    int start_col = 1 + (inner_width - total_length) / 2;
-    int start_row = 1 + (inner_height - 3) / 2;
-    // * 1st rop: [w]  [e]  [r]
-    mvwprintw(right_box, start_row, start_col, "[w]");
-    mvwprintw(right_box, start_row, start_col + 5, "[e]");
-    mvwprintw(right_box, start_row, start_col + 10, "[r]");
-    // * 2nd rop: [s]  [d]  [f]
-    mvwprintw(right_box, start_row + 1, start_col, "[s]");
-    mvwprintw(right_box, start_row + 1, start_col + 5, "[d]");
-    mvwprintw(right_box, start_row + 1, start_col + 10, "[f]");
-    // * 3rd row: [x]  [c]  [v]
-    mvwprintw(right_box, start_row + 2, start_col, "[x]");
-    mvwprintw(right_box, start_row + 2, start_col + 5, "[c]");
-    mvwprintw(right_box, start_row + 2, start_col + 10, "[v]");
-    wrefresh(right_box);
+    char painted[INSPECTOR_LINES][INSPECTOR_LINE_LENGTH] = {{0}};
+    paint_line(left_box, painted, 1, "Drone Position: N/A");
+    paint_line(left_box, painted, 2, "Velocity: N/A");
+    paint_line(left_box, painted, 3, "Force: N/A");
+    wnoutrefresh(left_box);
+    // * Draw the keypad, no key highlighted
+    char painted_key = '-';
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            paint_key(right_box, keypad_keys[row][col], FALSE);
+        }
+    }
+    wnoutrefresh(right_box);
+    doupdate();
 
+    // * Map the status page written by the Blackboard
+    telemetry_shm_t *telemetry;
+    while ((telemetry = telemetry_shm_open(0)) == NULL && keep_running) {
+        sleep(1);
+    }
+    uint64_t last_frame = 0, last_stats_seq = 0;
     while (keep_running) {
-        char insp_msg[128] = {0};
-        int fd = open(INSPECTOR_FIFO, O_RDONLY);
-        if (fd == -1) {
+        // * Read the page at most INSPECTOR_REFRESH_RATE times per second: only the newest frame is shown, and
+        // * the percentiles refreshed while the game is idle are shown too
+        usleep((useconds_t)(1e6 / INSPECTOR_REFRESH_RATE));
+        telemetry_t status;
+        telemetry_shm_read(telemetry, &status);
+        if (status.frame == last_frame && status.stats_seq == last_stats_seq) {
             continue;
         }
-        int ret = read(fd, insp_msg, sizeof(insp_msg) - 1);
-        if (ret == -1) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                close(fd);
-                continue;
-            } else {
-                perror("read");
-                close(fd);
-                return EXIT_FAILURE;
-            }
+        last_frame = status.frame;
+        last_stats_seq = status.stats_seq;
+        // * Only the lines whose text changed are written in the left_box
+        char line[INSPECTOR_LINE_LENGTH];
+        int changed = 0;
+        snprintf(line, sizeof(line), "Drone Position: (%d, %d)", status.pos_x, status.pos_y);
+        changed += paint_line(left_box, painted, 1, line);
+        snprintf(line, sizeof(line), "Velocity: (%d, %d)", status.vel_x, status.vel_y);
+        changed += paint_line(left_box, painted, 2, line);
+        snprintf(line, sizeof(line), "Force: (%d, %d)", status.force_x, status.force_y);
+        changed += paint_line(left_box, painted, 3, line);
+        snprintf(line, sizeof(line), "Frame: %llu  Score: %d", (unsigned long long)status.frame, status.score);
+        changed += paint_line(left_box, painted, 4, line);
+        // * Latency of the stages of the Blackboard, in microseconds
+        snprintf(line, sizeof(line), "%-11s %8s %8s %8s", "stage", "p50", "p99", "max");
+        changed += paint_line(left_box, painted, 6, line);
+        for (int i = 0; i < TELEMETRY_MAX_STAGES && status.stages[i].name[0] != '\0'; i++) {
+            const telemetry_stage_t *stage = &status.stages[i];
+            snprintf(line, sizeof(line), "%-11.11s %8.1f %8.1f %8.1f", stage->name, stage->p50_ns / 1e3,
+                     stage->p99_ns / 1e3, stage->max_ns / 1e3);
+            changed += paint_line(left_box, painted, 7 + i, line);
         }
-        insp_msg[ret] = '\0';
-        close(fd);
-
-        if (ret > 0) {
-            char c;
-            int force_x, force_y, pos_x, pos_y, vel_x, vel_y;
-            if (sscanf(insp_msg, "%d,%d,%d,%d,%d,%d,%c",
-                       &force_x, &force_y, &pos_x, &pos_y, &vel_x, &vel_y, &c) != 7) {
-                mvwprintw(left_box, 5, 1, "Invalid message format:");
-                mvwprintw(left_box, 6, 1, "%s", insp_msg);
-                wrefresh(left_box);
-                continue;
-            }
-            // * Update the kaypad in the left_box
-            wclear(left_box);
-            box(left_box, 0, 0);
-            mvwprintw(left_box, 1, 1, "Drone Position: (%d, %d)", pos_x, pos_y);
-            mvwprintw(left_box, 2, 1, "Velocity: (%d, %d)", vel_x, vel_y);
-            mvwprintw(left_box, 3, 1, "Force: (%d, %d)", force_x, force_y);
-            wrefresh(left_box);
-            // * Update the keypad in the right_box
-            wclear(right_box);
-            box(right_box, 0, 0);
-            getmaxyx(right_box, rH, rW);
-            inner_width = rW - 2;
-            inner_height = rH - 2;
-            start_col = 1 + (inner_width - total_length) / 2;
-            start_row = 1 + (inner_height - 3) / 2;
-            // * [w] [e] [r]
-            if (c == 'w') {
-                wattron(right_box, COLOR_PAIR(4));
-                mvwprintw(right_box, start_row, start_col, "[w]");
-                wattroff(right_box, COLOR_PAIR(4));
-            } else {
-                mvwprintw(right_box, start_row, start_col, "[w]");
-            }
-            if (c == 'e') {
-                wattron(right_box, COLOR_PAIR(4));
-                mvwprintw(right_box, start_row, start_col + 5, "[e]");
-                wattroff(right_box, COLOR_PAIR(4));
-            } else {
-                mvwprintw(right_box, start_row, start_col + 5, "[e]");
-            }
-            if (c == 'r') {
-                wattron(right_box, COLOR_PAIR(4));
-                mvwprintw(right_box, start_row, start_col + 10, "[r]");
-                wattroff(right_box, COLOR_PAIR(4));
-            } else {
-                mvwprintw(right_box, start_row, start_col + 10, "[r]");
-            }
-            // * [s] [d] [f]
-            if (c == 's') {
-                wattron(right_box, COLOR_PAIR(4));
-                mvwprintw(right_box, start_row + 1, start_col, "[s]");
-                wattroff(right_box, COLOR_PAIR(4));
-            } else {
-                mvwprintw(right_box, start_row + 1, start_col, "[s]");
-            }
-            if (c == 'd') {
-                wattron(right_box, COLOR_PAIR(4));
-                mvwprintw(right_box, start_row + 1, start_col + 5, "[d]");
-                wattroff(right_box, COLOR_PAIR(4));
-            } else {
-                mvwprintw(right_box, start_row + 1, start_col + 5, "[d]");
-            }
-            if (c == 'f') {
-                wattron(right_box, COLOR_PAIR(4));
-                mvwprintw(right_box, start_row + 1, start_col + 10, "[f]");
-                wattroff(right_box, COLOR_PAIR(4));
-            } else {
-                mvwprintw(right_box, start_row + 1, start_col + 10, "[f]");
-            }
-            // * [x] [c] [v]
-            if (c == 'x') {
-                wattron(right_box, COLOR_PAIR(4));
-                mvwprintw(right_box, start_row + 2, start_col, "[x]");
-                wattroff(right_box, COLOR_PAIR(4));
-            } else {
-                mvwprintw(right_box, start_row + 2, start_col, "[x]");
-            }
-            if (c == 'c') {
-                wattron(right_box, COLOR_PAIR(4));
-                mvwprintw(right_box, start_row + 2, start_col + 5, "[c]");
-                wattroff(right_box, COLOR_PAIR(4));
-            } else {
-                mvwprintw(right_box, start_row + 2, start_col + 5, "[c]");
-            }
-            if (c == 'v') {
-                wattron(right_box, COLOR_PAIR(4));
-                mvwprintw(right_box, start_row + 2, start_col + 10, "[v]");
-                wattroff(right_box, COLOR_PAIR(4));
-            } else {
-                mvwprintw(right_box, start_row + 2, start_col + 10, "[v]");
-            }
+        if (changed) {
+            wnoutrefresh(left_box);
+        }
+        // * Only the key released and the key pressed are written in the right_box
+        if (status.key != painted_key) {
+            paint_key(right_box, painted_key, FALSE);
+            paint_key(right_box, status.key, TRUE);
+            painted_key = status.key;
+            wnoutrefresh(right_box);
+            changed++;
+        }
+        // * One update of the terminal for both boxes
+        if (changed) {
+            doupdate();
         }
-        wrefresh(right_box);
     }
     // * Cleanup
+    telemetry_shm_close(telemetry);
     delwin(left_box);
     delwin(right_box);
     delwin(inspect_win);
@@ -195,4 +132,43 @@ int main() {
 
 void signal_close(int signum) {
     keep_running = 0;
-}
\ No newline at end of file
+}
+
+int paint_line(WINDOW *win, char painted[INSPECTOR_LINES][INSPECTOR_LINE_LENGTH], const int row, const char *text) {
+    /*
+     * Write a line of a box only if its text changed since it was last painted.
+     * The text is padded to the inner width of the box, so that a shorter text covers the previous one.
+     * @param win The box.
+     * @param painted Text currently shown in each line.
+     * @param row Line of the box (1 is the first inside the border).
+     * @param text The new text.
+     * @return 1 if the line was written, 0 otherwise.
+    */
+    if (row >= INSPECTOR_LINES || row >= getmaxy(win) - 1 || strcmp(painted[row], text) == 0) {
+        return 0;
+    }
+    const int inner_width = getmaxx(win) - 2;
+    mvwprintw(win, row, 1, "%-*.*s", inner_width, inner_width, text);
+    snprintf(painted[row], INSPECTOR_LINE_LENGTH, "%s", text);
+    return 1;
+}
+
+void paint_key(WINDOW *win, const char key, const bool highlighted) {
+    /*
+     * Draw a key of the keypad, centred in the box, highlighted or not. Keys not in the keypad are ignored.
+     * - 1st row: [w]  [e]  [r]
+     * - 2nd row: [s]  [d]  [f]
+     * - 3rd row: [x]  [c]  [v]
+    */
+    const int total_length = 13;
+    const int start_col = 1 + (getmaxx(win) - 2 - total_length) / 2;
+    const int start_row = 1 + (getmaxy(win) - 2 - 3) / 2;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            if (keypad_keys[row][col] != key) continue;
+            if (highlighted) wattron(win, COLOR_PAIR(4));
+            mvwprintw(win, start_row + row, start_col + 5 * col, "[%c]", key);
+            if (highlighted) wattroff(win, COLOR_PAIR(4));
+        }
+    }
+}
@@ -0,0 +1,60 @@
+//
+// Created by Gian Marco Balia
+//
+// src/latency_histogram.c
+#include <string.h>
+#include "latency_histogram.h"
+
+void latency_init(latency_histogram_t *histogram, const char *name) {
+    /*
+     * Empty a histogram.
+     * @param name Name of the stage (not copied).
+    */
+    memset(histogram, 0, sizeof(*histogram));
+    histogram->name = name;
+}
+
+static uint64_t bucket_high(const int bucket) {
+    // * Highest value kept in a bucket
+    if (bucket < LATENCY_SUB_BUCKETS) return (uint64_t)bucket;
+    const int exponent = bucket / LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKET_BITS - 1;
+    const uint64_t sub_bucket = (uint64_t)(bucket % LATENCY_SUB_BUCKETS);
+    const int shift = exponent - LATENCY_SUB_BUCKET_BITS;
+    return ((LATENCY_SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+}
+
+uint64_t latency_percentile(const latency_histogram_t *histogram, const double percentile) {
+    /*
+     * Value below which a percentage of the recorded values falls.
+     * @param percentile Percentage, 0 to 100.
+     * @return The value in nanoseconds (upper bound of its bucket, at most the maximum), 0 if empty.
+    */
+    if (histogram->count == 0) return 0;
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)histogram->count + 0.5);
+    rank = rank < 1 ? 1 : (rank > histogram->count ? histogram->count : rank);
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += histogram->buckets[bucket];
+        if (seen >= rank) {
+            const uint64_t high = bucket_high(bucket);
+            return high < histogram->max_ns ? high : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+void latency_report(FILE *out, const latency_histogram_t *histograms, const int count) {
+    /*
+     * Print one line per histogram: samples, mean, p50, p99 and max in microseconds.
+    */
+    fprintf(out, "%-14s %10s %10s %10s %10s %10s\n", "stage", "count", "mean_us", "p50_us", "p99_us", "max_us");
+    for (int i = 0; i < count; i++) {
+        const latency_histogram_t *histogram = &histograms[i];
+        const double mean = histogram->count ? (double)histogram->sum_ns / (double)histogram->count : 0.0;
+        fprintf(out, "%-14s %10llu %10.1f %10.1f %10.1f %10.1f\n", histogram->name,
+            (unsigned long long)histogram->count, mean / 1e3,
+            (double)latency_percentile(histogram, 50.0) / 1e3, (double)latency_percentile(histogram, 99.0) / 1e3,
+            (double)histogram->max_ns / 1e3);
+    }
+    fflush(out);
+}
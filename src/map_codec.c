@@ -0,0 +1,144 @@
+//
+// Created by Gian Marco Balia
+//
+// src/map_codec.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "map_codec.h"
+
+static size_t put_varint(uint8_t *out, uint32_t value) {
+    // * LEB128: 7 bits per byte, the high bit set on all the bytes but the last
+    size_t size = 0;
+    while (value >= 0x80) {
+        out[size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = (uint8_t)value;
+    return size;
+}
+
+static int get_varint(const uint8_t *in, const size_t size, size_t *at, uint32_t *value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 7 * MAP_CODEC_VARINT_BYTES && *at < size; shift += 7) {
+        const uint8_t byte = in[(*at)++];
+        result |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+size_t map_codec_encode(const uint64_t *bits, uint8_t *payload, uint8_t *encoding) {
+    /*
+     * Encode a layer of a bitgrid in the smaller of the two encodings.
+     * @param bits The layer (obstacles or targets of a bitgrid_t).
+     * @param payload Output, MAP_CODEC_MAX_BYTES long.
+     * @param encoding Output, MAP_ENCODING_PAIRS or MAP_ENCODING_RLE.
+     * @return Bytes of the payload.
+    */
+    const size_t pairs_size = 4 * (size_t)bitgrid_count(bits);
+    // * Runs first, given up as soon as they are not smaller than the pairs
+    size_t size = 0;
+    int cursor = 0, run_start = 0, run_end = 0;
+    for (int i = bitgrid_next(bits, 0); ; i = bitgrid_next(bits, i + 1)) {
+        if (i >= 0 && i == run_end && run_end > run_start) {
+            run_end++;
+            continue;
+        }
+        if (run_end > run_start) {
+            size += put_varint(payload + size, (uint32_t)(run_start - cursor));
+            size += put_varint(payload + size, (uint32_t)(run_end - run_start));
+            cursor = run_end;
+            if (size >= pairs_size) break;
+        }
+        if (i < 0) break;
+        run_start = i;
+        run_end = i + 1;
+    }
+    if (size < pairs_size) {
+        *encoding = MAP_ENCODING_RLE;
+        return size;
+    }
+    *encoding = MAP_ENCODING_PAIRS;
+    size = 0;
+    for (int i = bitgrid_next(bits, 0); i >= 0; i = bitgrid_next(bits, i + 1)) {
+        const uint16_t col = (uint16_t)(i % GAME_WIDTH);
+        const uint16_t row = (uint16_t)(i / GAME_WIDTH);
+        payload[size++] = (uint8_t)col;
+        payload[size++] = (uint8_t)(col >> 8);
+        payload[size++] = (uint8_t)row;
+        payload[size++] = (uint8_t)(row >> 8);
+    }
+    return size;
+}
+
+int map_codec_decode(const uint8_t encoding, const uint8_t *payload, const size_t size, const int width,
+    const int height, const int count, int32_t *x, int32_t *y) {
+    /*
+     * Decode a layer into the coordinates of its occupied cells, checking every field against the header.
+     * @param encoding, payload, size The payload and its encoding.
+     * @param width, height, count Map size and occupied cells, from the header of the sample.
+     * @param x, y Output, count coordinates each.
+     * @return 0 on success, -1 if the payload is malformed or does not match the header.
+    */
+    if (width <= 0 || height <= 0 || (int64_t)width * height > MAP_CODEC_MAX_CELLS) return -1;
+    const int cells = width * height;
+    if (count < 0 || count > cells) return -1;
+    if (encoding == MAP_ENCODING_PAIRS) {
+        if (size != 4 * (size_t)count) return -1;
+        for (int i = 0; i < count; i++) {
+            const uint8_t *pair = payload + 4 * i;
+            x[i] = pair[0] | pair[1] << 8;
+            y[i] = pair[2] | pair[3] << 8;
+            if (x[i] >= width || y[i] >= height) return -1;
+        }
+        return 0;
+    }
+    if (encoding == MAP_ENCODING_RLE) {
+        size_t at = 0;
+        int64_t cell = 0;
+        int decoded = 0;
+        while (at < size) {
+            uint32_t empty, occupied;
+            if (get_varint(payload, size, &at, &empty) == -1 || get_varint(payload, size, &at, &occupied) == -1) {
+                return -1;
+            }
+            cell += empty;
+            // * The encoder never writes an empty occupied run: one is padding, or a forged payload
+            if (occupied == 0 || occupied > (uint32_t)(count - decoded) || cell + occupied > cells) return -1;
+            for (uint32_t k = 0; k < occupied; k++, cell++, decoded++) {
+                x[decoded] = (int32_t)(cell % width);
+                y[decoded] = (int32_t)(cell / width);
+            }
+        }
+        return decoded == count ? 0 : -1;
+    }
+    return -1;
+}
+
+int map_codec_format(const int fallback) {
+    /*
+     * Map formats to publish or read, from MAP_FORMAT_ENV.
+     * @param fallback Formats if it is not set, or lists no known format: MAP_FORMAT_PUBLISH_DEFAULT for a
+     * publisher, MAP_FORMAT_READ_DEFAULT for the Blackboard.
+     * @return MAP_FORMAT_* flags: a publisher sends all of them, the Blackboard reads the first one set of
+     * items, compact and legacy.
+    */
+    const char *value = getenv(MAP_FORMAT_ENV);
+    if (value == NULL || *value == '\0') return fallback;
+    char names[64];
+    snprintf(names, sizeof(names), "%s", value);
+    int format = 0;
+    char *save;
+    for (const char *name = strtok_r(names, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save)) {
+        if (strcmp(name, "compact") == 0) format |= MAP_FORMAT_COMPACT;
+        else if (strcmp(name, "legacy") == 0) format |= MAP_FORMAT_LEGACY;
+        else if (strcmp(name, "items") == 0) format |= MAP_FORMAT_ITEMS;
+        else if (strcmp(name, "both") == 0) format |= MAP_FORMAT_BOTH;
+        else fprintf(stderr, "Unknown map format \"%s\" in %s\n", name, MAP_FORMAT_ENV);
+    }
+    return format != 0 ? format : fallback;
+}
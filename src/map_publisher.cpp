@@ -0,0 +1,248 @@
+//
+// Created by Gian Marco Balia
+//
+// src/map_publisher.cpp
+#include <iostream>
+#include <string.h>
+#include "dds_qos.h"
+#include "dds_transport.h"
+#include "map_codec.h"
+#include "map_publisher.h"
+#include <fastdds/dds/domain/DomainParticipantFactory.hpp>
+
+using namespace eprosima::fastdds::dds;
+
+static_assert(MAP_LAYER_PLAIN_BYTES >= MAP_CODEC_MAX_BYTES, "MapLayerPlain payload smaller than a map layer");
+
+MapPublisher::MapPublisher(const MapPublisherTopics &topics, TopicDataType *legacy_type)
+    : topics_(topics)
+    , participant_(nullptr)
+    , publisher_(nullptr)
+    , topic_(nullptr)
+    , layer_topic_(nullptr)
+    , items_topic_(nullptr)
+    , writer_(nullptr)
+    , layer_writer_(nullptr)
+    , items_writer_(nullptr)
+    , type_(legacy_type)
+    , layer_type_(new MapLayerPubSubType())
+    , item_type_(new MapItemPubSubType())
+    , plain_type_(new MapLayerPlainPubSubType())
+    , format_(map_codec_format(MAP_FORMAT_PUBLISH_DEFAULT))
+    , transport_(dds_transport_mode())
+    , plain_(false)
+{
+    memset(items_published_, 0, sizeof(items_published_));
+}
+
+MapPublisher::~MapPublisher() {
+    if (writer_ != nullptr) {
+        publisher_->delete_datawriter(writer_);
+    }
+    if (layer_writer_ != nullptr) {
+        publisher_->delete_datawriter(layer_writer_);
+    }
+    if (items_writer_ != nullptr) {
+        publisher_->delete_datawriter(items_writer_);
+    }
+    if (publisher_ != nullptr) {
+        participant_->delete_publisher(publisher_);
+    }
+    if (topic_ != nullptr) {
+        participant_->delete_topic(topic_);
+    }
+    if (layer_topic_ != nullptr) {
+        participant_->delete_topic(layer_topic_);
+    }
+    if (items_topic_ != nullptr) {
+        participant_->delete_topic(items_topic_);
+    }
+    DomainParticipantFactory::get_instance()->delete_participant(participant_);
+}
+
+void MapPublisher::PubListener::on_publication_matched(DataWriter* writer, const PublicationMatchedStatus& info) {
+    if (info.current_count_change == 1 || info.current_count_change == -1) {
+        // * A durable writer hands its last map to the new reader by itself; a VOLATILE one (from the QoS
+        // * profiles) has nothing for it, so every item is sent with the next map, published at once if a
+        // * scheduler drives the process
+        if (info.current_count_change == 1 && writer->get_qos().durability().kind == VOLATILE_DURABILITY_QOS) {
+            resync_ = true;
+            if (scheduler_ != nullptr) {
+                scheduler_->notify_change();
+            }
+        }
+    } else {
+        std::cout << info.current_count_change
+                  << " is not a valid value for PublicationMatchedStatus current count change." << std::endl;
+    }
+}
+
+void MapPublisher::resync_with(PublishScheduler *scheduler) {
+    /*
+     * Ask the scheduler of the process for a map as soon as a reader matches a VOLATILE writer.
+     * @param scheduler The scheduler, alive as long as the publisher.
+    */
+    listener_.scheduler_ = scheduler;
+}
+
+bool MapPublisher::init(FILE *log) {
+    /*
+     * Create the participant, as the discovery server of the process, and the writers of the formats chosen.
+     * @param log The logfile, where dds_qos_load writes which QoS is in use.
+     * @return false if any DDS entity could not be created.
+    */
+    DomainParticipantQos participantQos = PARTICIPANT_QOS_DEFAULT;
+
+    // * Configure the current participant as SERVER, listening on the ip:port of the process
+    dds_transport_server(participantQos, transport_, topics_.ip, topics_.port);
+
+    participant_ = DomainParticipantFactory::get_instance()->create_participant(0, participantQos);
+    if (participant_ == nullptr) {
+        std::cerr << "Failed to create DomainParticipant with TCP/Discovery configuration in " << topics_.name
+                  << " generator" << std::endl;
+        return false;
+    }
+
+    publisher_ = participant_->create_publisher(PUBLISHER_QOS_DEFAULT, nullptr);
+    if (publisher_ == nullptr) {
+        return false;
+    }
+
+    // * Durable QoS of the map topics, or the profiles of QOS_FILE_ENV
+    dds_qos_load(log);
+    DataWriterQos writer_qos;
+
+    // * Legacy type, kept for the readers not migrated yet
+    if (format_ & MAP_FORMAT_LEGACY) {
+        type_.register_type(participant_, topics_.name);
+        topic_ = participant_->create_topic(topics_.legacy, topics_.name, TOPIC_QOS_DEFAULT);
+        if (topic_ == nullptr) {
+            return false;
+        }
+        dds_qos_writer(publisher_, topic_, 1, writer_qos);
+        dds_transport_data_sharing(writer_qos, transport_);
+        writer_ = publisher_->create_datawriter(topic_, writer_qos, &listener_);
+        if (writer_ == nullptr) {
+            return false;
+        }
+    }
+    // * Compact MapLayer type, or its bounded MapLayerPlain variant loaned in shared memory
+    if ((format_ & MAP_FORMAT_COMPACT) && transport_ == DDS_TRANSPORT_SHM) {
+        plain_type_.register_type(participant_, "MapLayerPlain");
+        layer_topic_ = participant_->create_topic(topics_.plain, "MapLayerPlain", TOPIC_QOS_DEFAULT);
+        plain_ = true;
+    } else if (format_ & MAP_FORMAT_COMPACT) {
+        layer_type_.register_type(participant_, "MapLayer");
+        layer_topic_ = participant_->create_topic(topics_.layer, "MapLayer", TOPIC_QOS_DEFAULT);
+    }
+    if (format_ & MAP_FORMAT_COMPACT) {
+        if (layer_topic_ == nullptr) {
+            return false;
+        }
+        dds_qos_writer(publisher_, layer_topic_, 1, writer_qos);
+        dds_transport_data_sharing(writer_qos, transport_);
+        layer_writer_ = publisher_->create_datawriter(layer_topic_, writer_qos, &listener_);
+        if (layer_writer_ == nullptr) {
+            return false;
+        }
+    }
+    // * Keyed MapItem type: an instance per cell, only its last sample kept
+    if (format_ & MAP_FORMAT_ITEMS) {
+        item_type_.register_type(participant_, "MapItem");
+        items_topic_ = participant_->create_topic(topics_.items, "MapItem", TOPIC_QOS_DEFAULT);
+        if (items_topic_ == nullptr) {
+            return false;
+        }
+        dds_qos_writer(publisher_, items_topic_, BITGRID_CELLS, writer_qos);
+        dds_transport_data_sharing(writer_qos, transport_);
+        items_writer_ = publisher_->create_datawriter(items_topic_, writer_qos, &listener_);
+        if (items_writer_ == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MapPublisher::publish_from_grid(const bitgrid_t *cells) {
+    /*
+     * Publish the plane of the process of a new map, in every format chosen.
+     * @param cells The map.
+    */
+    const uint64_t *bits = topics_.plane == CELL_OBSTACLE ? cells->obstacles : cells->targets;
+    // * The durable writers keep the last map and hand it to the late readers by themselves:
+    // * do not wait the readers nor the acks
+    if (writer_ != nullptr) {
+        writer_->write(legacy_sample(bits));
+    }
+    if (layer_writer_ != nullptr && plain_) {
+        publish_plain(bits);
+    }
+    else if (layer_writer_ != nullptr) {
+        // * Encode the layer in the smaller of packed pairs and runs (map_codec.h)
+        std::vector<uint8_t> &payload = layer_message_.payload();
+        payload.resize(MAP_CODEC_MAX_BYTES);
+        uint8_t encoding;
+        payload.resize(map_codec_encode(bits, payload.data(), &encoding));
+        layer_message_.version(MAP_CODEC_VERSION);
+        layer_message_.encoding(encoding);
+        layer_message_.width(GAME_WIDTH);
+        layer_message_.height(GAME_HEIGHT);
+        layer_message_.count(bitgrid_count(bits));
+        layer_writer_->write(&layer_message_);
+    }
+    if (items_writer_ != nullptr) {
+        publish_items(bits);
+    }
+}
+
+void MapPublisher::publish_plain(const uint64_t *bits) {
+    /*
+     * Encode a layer straight into a sample loaned by the writer in the shared segment: the readers on this
+     * host read it in place, with no copy and no serialization.
+     * @param bits The layer to publish.
+    */
+    void *loaned = nullptr;
+    MapLayerPlain *sample = &plain_message_;
+    if (layer_writer_->loan_sample(loaned) == RETCODE_OK) {
+        sample = static_cast<MapLayerPlain *>(loaned);
+    }
+    uint8_t encoding;
+    sample->size(static_cast<uint32_t>(map_codec_encode(bits, sample->payload().data(), &encoding)));
+    sample->version(MAP_CODEC_VERSION);
+    sample->encoding(encoding);
+    sample->width(GAME_WIDTH);
+    sample->height(GAME_HEIGHT);
+    sample->count(bitgrid_count(bits));
+    if (layer_writer_->write(sample) != RETCODE_OK && loaned != nullptr) {
+        layer_writer_->discard_loan(loaned);
+    }
+}
+
+void MapPublisher::publish_items(const uint64_t *bits) {
+    /*
+     * Write the cells that appeared since the last map and dispose the ones that disappeared, so the
+     * traffic follows the changes and not the size of the map. A durable writer keeps the last sample of
+     * every cell alive for the late readers; after a reader matched a VOLATILE one, every cell is written again.
+     * @param bits The layer to publish.
+    */
+    const bool snapshot = listener_.resync_.exchange(false);
+    item_message_.width(GAME_WIDTH);
+    item_message_.height(GAME_HEIGHT);
+    for (int word = 0; word < BITGRID_WORDS; word++) {
+        const uint64_t removed = items_published_[word] & ~bits[word];
+        const uint64_t added = snapshot ? bits[word] : bits[word] & ~items_published_[word];
+        for (uint64_t mask = removed; mask != 0; mask &= mask - 1) {
+            const int index = word * 64 + __builtin_ctzll(mask);
+            item_message_.x(index % GAME_WIDTH);
+            item_message_.y(index / GAME_WIDTH);
+            items_writer_->dispose(&item_message_, HANDLE_NIL);
+        }
+        for (uint64_t mask = added; mask != 0; mask &= mask - 1) {
+            const int index = word * 64 + __builtin_ctzll(mask);
+            item_message_.x(index % GAME_WIDTH);
+            item_message_.y(index / GAME_WIDTH);
+            items_writer_->write(&item_message_);
+        }
+        items_published_[word] = bits[word];
+    }
+}
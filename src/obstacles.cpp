@@ -11,175 +11,73 @@
 #include <cstdlib>
 #include <cstring>
 #include <chrono>
-#include <thread>
-#include <atomic>
 #include <ctime>
 #include "macros.h"
-#include <fastdds/dds/domain/DomainParticipant.hpp>
-#include <fastdds/dds/domain/DomainParticipantFactory.hpp>
-#include <fastdds/dds/publisher/DataWriter.hpp>
-#include <fastdds/dds/publisher/DataWriterListener.hpp>
-#include <fastdds/dds/publisher/Publisher.hpp>
-#include <fastdds/dds/topic/TypeSupport.hpp>
-#include <fastdds/rtps/transport/TCPv4TransportDescriptor.hpp>
-#include <fastdds/utils/IPLocator.hpp>
+#include "bitgrid.h"
+#include "map_publisher.h"
+#include "publish_scheduler.h"
 #include "ObstaclesPubSubTypes.hpp"
 
-using namespace eprosima::fastdds::dds;
-using namespace eprosima::fastdds::rtps;
-using namespace std::chrono_literals;
+// * Server and topics of the obstacles
+static const MapPublisherTopics obstacles_topics = {
+    "Obstacles", IPV4_OBSTACLES_SERVER, TCP_LISTENING_PORT_OBSTACLES, CELL_OBSTACLE,
+    TOPIC_NAME_OBSTACLES, TOPIC_NAME_OBSTACLES_LAYER, TOPIC_NAME_OBSTACLES_PLAIN, TOPIC_NAME_OBSTACLES_ITEMS,
+};
 
 FILE* logfile;
 static volatile sig_atomic_t keep_running = 1;
 
-class CustomTransportPublisher {
+class CustomTransportPublisher : public MapPublisher {
 private:
-    // * DDS Message (defined in Obstacles.idl)
+    // * Legacy DDS Message (defined in Obstacles.idl)
     Obstacles my_message_;
-    DomainParticipant* participant_;
-    Publisher* publisher_;
-    Topic* topic_;
-    DataWriter* writer_;
-    TypeSupport type_;
-
-    class PubListener : public DataWriterListener {
-    public:
-        std::atomic_int matched_;
-        PubListener() : matched_(0) {}
-        ~PubListener() override {}
-
-        void on_publication_matched(DataWriter* writer, const PublicationMatchedStatus& info) override {
-            if (info.current_count_change == 1) {
-                matched_ = info.total_count;
-            } else if (info.current_count_change == -1) {
-                matched_ = info.total_count;
-                //std::cout << "Publisher unmatched." << std::endl;
-            } else {
-                std::cout << info.current_count_change
-                          << " is not a valid value for PublicationMatchedStatus current count change." << std::endl;
-            }
-        }
-    } listener_;
-
-public:
-    CustomTransportPublisher()
-        : participant_(nullptr)
-        , publisher_(nullptr)
-        , topic_(nullptr)
-        , writer_(nullptr)
-        , type_(new ObstaclesPubSubType())
-    { }
-
-    virtual ~CustomTransportPublisher() {
-        if (writer_ != nullptr) {
-            publisher_->delete_datawriter(writer_);
-        }
-        if (publisher_ != nullptr) {
-            participant_->delete_publisher(publisher_);
-        }
-        if (topic_ != nullptr) {
-            participant_->delete_topic(topic_);
-        }
-        DomainParticipantFactory::get_instance()->delete_participant(participant_);
-    }
-
-    bool init() {
-        my_message_.obstacles_number(0);
-
-        DomainParticipantQos participantQos = PARTICIPANT_QOS_DEFAULT;
-
-        //participantQos.name("Obstacles_Publisher");
-
-        // * Configure the current participant as SERVER
-        participantQos.wire_protocol().builtin.discovery_config.discoveryProtocol = DiscoveryProtocol::SERVER;
-
-        // * Add custom user transport with TCP port TCP_LISTENING_PORT_OBSTACLES
-        auto data_transport = std::make_shared<TCPv4TransportDescriptor>();
-        data_transport->add_listener_port(TCP_LISTENING_PORT_OBSTACLES);
-        participantQos.transport().user_transports.push_back(data_transport);
+    PublishScheduler scheduler_;
 
-        // * Define the listening locator to be on interface IPV4_OBSTACLES_SERVER and port TCP_LISTENING_PORT_OBSTACLES
-        constexpr uint16_t tcp_listening_port = TCP_LISTENING_PORT_OBSTACLES;
-        Locator_t listening_locator;
-        IPLocator::setIPv4(listening_locator, IPV4_OBSTACLES_SERVER);
-        IPLocator::setPhysicalPort(listening_locator, tcp_listening_port);
-        IPLocator::setLogicalPort(listening_locator, tcp_listening_port);
-        participantQos.wire_protocol().builtin.metatrafficUnicastLocatorList.push_back(listening_locator);
-
-        participant_ = DomainParticipantFactory::get_instance()->create_participant(0, participantQos);
-        if (participant_ == nullptr) {
-            std::cerr << "Failed to create DomainParticipant with TCP/Discovery configuration in Obstacles generator" << std::endl;
-            return false;
-        }
-
-        type_.register_type(participant_, "Obstacles");
-        topic_ = participant_->create_topic(TOPIC_NAME_OBSTACLES, "Obstacles", TOPIC_QOS_DEFAULT);
-        if (topic_ == nullptr) {
-            return false;
-        }
-
-        publisher_ = participant_->create_publisher(PUBLISHER_QOS_DEFAULT, nullptr);
-        if (publisher_ == nullptr) {
-            return false;
-        }
-
-        writer_ = publisher_->create_datawriter(topic_, DATAWRITER_QOS_DEFAULT, &listener_);
-        if (writer_ == nullptr) {
-            return false;
-        }
-        return true;
-    }
-
-    bool publish_from_grid(const char grid[GAME_HEIGHT][GAME_WIDTH]) {
+    void *legacy_sample(const uint64_t *bits) override {
         // * Clean previous sequeces
         my_message_.obstacles_x().clear();
         my_message_.obstacles_y().clear();
-        int count = 0;
-        for (int r = 0; r < GAME_HEIGHT; r++) {
-            for (int c = 0; c < GAME_WIDTH; c++) {
-                if (grid[r][c] == 'o') {
-                    my_message_.obstacles_x().push_back(c);
-                    my_message_.obstacles_y().push_back(r);
-                    count++;
-                }
-            }
+        // * Visit only the obstacles, a word of the bitset at a time
+        for (int i = bitgrid_next(bits, 0); i >= 0; i = bitgrid_next(bits, i + 1)) {
+            my_message_.obstacles_x().push_back(i % GAME_WIDTH);
+            my_message_.obstacles_y().push_back(i / GAME_WIDTH);
         }
-        my_message_.obstacles_number(count);
+        my_message_.obstacles_number(bitgrid_count(bits));
+        return &my_message_;
+    }
 
-        int flag = 0;
-        while (!flag || keep_running) {
-            if (listener_.matched_ > 0) {
-                writer_->write(&my_message_);
-                Duration_t timeout;
-                timeout.seconds = 5;
-                timeout.nanosec = 0;
-                writer_->wait_for_acknowledgments(timeout);
-                flag = 1;
-            }
-        }
-        return true;
+public:
+    CustomTransportPublisher()
+        : MapPublisher(obstacles_topics, new ObstaclesPubSubType())
+        , scheduler_(PublishScheduler::period_from_env(MAP_PERIOD_ENV, std::chrono::milliseconds(MAP_PERIOD_MS)),
+            &keep_running)
+    {
+        // * A reader matched to a VOLATILE writer gets a new map at once
+        resync_with(&scheduler_);
     }
 
     void run(uint32_t total_obstacles, int write_fd) {
         srand(static_cast<unsigned int>(time(NULL)));
-        while (keep_running) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-            char grid[GAME_HEIGHT][GAME_WIDTH];
-            memset(grid, ' ', sizeof(grid));
+        // * The first map at once, then a new one every period (asleep otherwise)
+        scheduler_.notify_change();
+        while (scheduler_.wait()) {
+            bitgrid_t cells;
+            bitgrid_clear(&cells);
             int i = 0;
             while (total_obstacles - i > 0) {
                 int x = (rand() % (GAME_WIDTH - 2)) + 1;
                 int y = (rand() % (GAME_HEIGHT - 2)) + 1;
-                if (grid[y][x] == ' ' && !(x == GAME_WIDTH / 2 && y == GAME_HEIGHT / 2)) {
-                    grid[y][x] = 'o';
+                const int index = bitgrid_index(x, y);
+                if (!bitgrid_test(cells.obstacles, index) && !(x == GAME_WIDTH / 2 && y == GAME_HEIGHT / 2)) {
+                    bitgrid_set(cells.obstacles, index);
                     i++;
                 }
             }
-            if (write(write_fd, grid, GAME_HEIGHT * GAME_WIDTH * sizeof(char)) == -1) {
+            if (write(write_fd, &cells, sizeof(cells)) == -1) {
                 perror("write");
                 EXIT_FAILURE;
             }
-            publish_from_grid(grid);
+            publish_from_grid(&cells);
         }
     }
 };
@@ -243,7 +141,7 @@ int main (int argc, char *argv[]) {
     // * Initialise and call the DDS server class paasing the random number of obstacles
     uint32_t total_obstacles = static_cast<int>(GAME_HEIGHT * GAME_WIDTH * 0.002);
     auto* mypub = new CustomTransportPublisher();
-    if (mypub->init()) {
+    if (mypub->init(logfile)) {
         mypub->run(total_obstacles, write_fd);
     }
 
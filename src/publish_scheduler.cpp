@@ -0,0 +1,72 @@
+//
+// Created by Gian Marco Balia
+//
+// src/publish_scheduler.cpp
+#include <stdlib.h>
+#include "publish_scheduler.h"
+
+PublishScheduler::PublishScheduler(const std::chrono::milliseconds period, const volatile sig_atomic_t *keep_running)
+    : changed_(false)
+    , period_(period)
+    , next_(std::chrono::steady_clock::now())
+    , keep_running_(keep_running)
+{ }
+
+void PublishScheduler::notify_change() {
+    /*
+     * The data to publish changed (or a listener asks for a publication): publish it now.
+    */
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        changed_ = true;
+    }
+    wake_.notify_all();
+}
+
+bool PublishScheduler::wait() {
+    /*
+     * Sleep until a publication is due.
+     * @return true to publish now, false if the process is stopping.
+    */
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        if (!*keep_running_) {
+            return false;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        const bool due = changed_ || (period_.count() > 0 && now >= next_);
+        if (due) {
+            changed_ = false;
+            if (period_.count() > 0) {
+                // * Keep the rate; after a late wake-up start again from now
+                next_ += period_;
+                if (next_ < now) next_ = now + period_;
+            }
+            return true;
+        }
+        auto deadline = now + STOP_CHECK;
+        if (period_.count() > 0 && next_ < deadline) {
+            deadline = next_;
+        }
+        wake_.wait_until(lock, deadline);
+    }
+}
+
+std::chrono::milliseconds PublishScheduler::period_from_env(const char *name,
+    const std::chrono::milliseconds fallback) {
+    /*
+     * Publication period from an environment variable, in milliseconds (0 publishes on change only).
+     * @param name The variable.
+     * @param fallback Period if the variable is not set or not a valid number.
+    */
+    const char *value = getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return fallback;
+    }
+    char *end;
+    const long period = strtol(value, &end, 10);
+    if (*end != '\0' || period < 0) {
+        return fallback;
+    }
+    return std::chrono::milliseconds(period);
+}
@@ -0,0 +1,43 @@
+//
+// Created by Gian Marco Balia
+//
+// src/spatial_index.c
+#include <string.h>
+#include "spatial_index.h"
+
+void spatial_index_build(spatial_index_t *index, const char grid[GAME_HEIGHT][GAME_WIDTH]) {
+    /*
+     * Build the bucket grid from the map (counting sort of the occupied cells by bucket).
+     * @param index The index to (re)build.
+     * @param grid The game map, ' ' marks an empty cell.
+    */
+    int *start = index->bucket_start;
+    memset(start, 0, sizeof(index->bucket_start));
+    // * First pass: count the occupied cells of each bucket
+    for (int row = 0; row < GAME_HEIGHT; row++) {
+        const int bucket_row = row / SPATIAL_BUCKET_SIZE;
+        for (int col = 0; col < GAME_WIDTH; col++) {
+            if (grid[row][col] == ' ') continue;
+            start[bucket_row * SPATIAL_BUCKET_COLS + col / SPATIAL_BUCKET_SIZE + 1]++;
+        }
+    }
+    // * Prefix sum to obtain the first entry of every bucket
+    for (int b = 0; b < SPATIAL_BUCKET_ROWS * SPATIAL_BUCKET_COLS; b++) {
+        start[b + 1] += start[b];
+    }
+    index->count = start[SPATIAL_BUCKET_ROWS * SPATIAL_BUCKET_COLS];
+    // * Second pass: scatter the cells in their bucket
+    int fill[SPATIAL_BUCKET_ROWS * SPATIAL_BUCKET_COLS];
+    memcpy(fill, start, sizeof(fill));
+    for (int row = 0; row < GAME_HEIGHT; row++) {
+        const int bucket_row = row / SPATIAL_BUCKET_SIZE;
+        for (int col = 0; col < GAME_WIDTH; col++) {
+            const char cell = grid[row][col];
+            if (cell == ' ') continue;
+            spatial_entry_t *entry = &index->entries[fill[bucket_row * SPATIAL_BUCKET_COLS + col / SPATIAL_BUCKET_SIZE]++];
+            entry->x = (short)col;
+            entry->y = (short)row;
+            entry->cell = cell;
+        }
+    }
+}
@@ -7,168 +7,66 @@
 #include <stdio.h>
 #include <string.h>
 #include <signal.h>
+#include <errno.h>
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
 #include <chrono>
-#include <thread>
-#include <atomic>
-
-#include <fastdds/dds/domain/DomainParticipant.hpp>
-#include <fastdds/dds/domain/DomainParticipantFactory.hpp>
-#include <fastdds/dds/publisher/DataWriter.hpp>
-#include <fastdds/dds/publisher/DataWriterListener.hpp>
-#include <fastdds/dds/publisher/Publisher.hpp>
-#include <fastdds/dds/topic/TypeSupport.hpp>
-#include <fastdds/rtps/transport/TCPv4TransportDescriptor.hpp>
-#include <fastdds/utils/IPLocator.hpp>
 
 #include "TargetsPubSubTypes.hpp"
 #include "macros.h"
+#include "bitgrid.h"
+#include "map_publisher.h"
 
 using namespace eprosima::fastdds::dds;
 using namespace eprosima::fastdds::rtps;
 using namespace std::chrono_literals;
 
+// * Server and topics of the targets
+static const MapPublisherTopics targets_topics = {
+    "Targets", IPV4_TARGETS_SERVER, TCP_LISTENING_PORT_TARGETS, CELL_TARGET,
+    TOPIC_NAME_TARGETS, TOPIC_NAME_TARGETS_LAYER, TOPIC_NAME_TARGETS_PLAIN, TOPIC_NAME_TARGETS_ITEMS,
+};
+
 // Puntatore globale al file di log
 FILE *logfile;
 static volatile sig_atomic_t keep_running = 1;
 
-class CustomTargetsPublisher {
+class CustomTargetsPublisher : public MapPublisher {
 private:
-    // * DDS Message (defined in Targets.idl)
+    // * Legacy DDS Message (defined in Targets.idl)
     Targets my_message_;
-    DomainParticipant* participant_;
-    Publisher* publisher_;
-    Topic* topic_;
-    DataWriter* writer_;
-    TypeSupport type_;
-
-    class PubListener : public DataWriterListener {
-    public:
-        std::atomic_int matched_;
-        PubListener() : matched_(0) {}
-        ~PubListener() override {}
-
-        void on_publication_matched(DataWriter* writer, const PublicationMatchedStatus& info) override {
-            if (info.current_count_change == 1) {
-                matched_ = info.total_count;
-            } else if (info.current_count_change == -1) {
-                matched_ = info.total_count;
-                //std::cout << "Publisher unmatched." << std::endl;
-            } else {
-                std::cout << info.current_count_change
-                          << " is not a valid value for PublicationMatchedStatus current count change." << std::endl;
-            }
-        }
-    } listener_;
-
-public:
-    CustomTargetsPublisher()
-        : participant_(nullptr)
-        , publisher_(nullptr)
-        , topic_(nullptr)
-        , writer_(nullptr)
-        , type_(new TargetsPubSubType())
-    { }
-
-    virtual ~CustomTargetsPublisher() {
-        if (writer_ != nullptr) {
-            publisher_->delete_datawriter(writer_);
-        }
-        if (publisher_ != nullptr) {
-            participant_->delete_publisher(publisher_);
-        }
-        if (topic_ != nullptr) {
-            participant_->delete_topic(topic_);
-        }
-        DomainParticipantFactory::get_instance()->delete_participant(participant_);
-    }
-
-    bool init() {
-        my_message_.targets_number(0);
-
-        DomainParticipantQos participantQos = PARTICIPANT_QOS_DEFAULT;
-
-        //participantQos.name("Targets_Publisher");
-
-        // * Configure the current participant as SERVER
-        participantQos.wire_protocol().builtin.discovery_config.discoveryProtocol = DiscoveryProtocol::SERVER;
 
-        // * Add custom user transport with TCP port TCP_LISTENING_PORT_TARGETS
-        auto data_transport = std::make_shared<TCPv4TransportDescriptor>();
-        data_transport->add_listener_port(TCP_LISTENING_PORT_TARGETS);
-        participantQos.transport().user_transports.push_back(data_transport);
-
-        // * Define the listening locator to be on interface IPV4_TARGETS_SERVER and port TCP_LISTENING_PORT_TARGETS
-        constexpr uint16_t tcp_listening_port = TCP_LISTENING_PORT_TARGETS;
-        Locator_t listening_locator;
-        IPLocator::setIPv4(listening_locator, IPV4_TARGETS_SERVER);
-        IPLocator::setPhysicalPort(listening_locator, tcp_listening_port);
-        IPLocator::setLogicalPort(listening_locator, tcp_listening_port);
-        participantQos.wire_protocol().builtin.metatrafficUnicastLocatorList.push_back(listening_locator);
-
-        participant_ = DomainParticipantFactory::get_instance()->create_participant(0, participantQos);
-        if (participant_ == nullptr) {
-            std::cerr << "Failed to create DomainParticipant with TCP/Discovery configuration in Targets generator" << std::endl;
-            return false;
-        }
-
-        type_.register_type(participant_, "Targets");
-        topic_ = participant_->create_topic(TOPIC_NAME_TARGETS, "Targets", TOPIC_QOS_DEFAULT);
-        if (topic_ == nullptr) {
-            return false;
-        }
-
-        publisher_ = participant_->create_publisher(PUBLISHER_QOS_DEFAULT, nullptr);
-        if (publisher_ == nullptr) {
-            return false;
-        }
-
-        writer_ = publisher_->create_datawriter(topic_, DATAWRITER_QOS_DEFAULT, &listener_);
-        if (writer_ == nullptr) {
-            return false;
-        }
-        return true;
-    }
-
-    bool publish_from_grid(const char grid[GAME_HEIGHT][GAME_WIDTH]) {
+    void *legacy_sample(const uint64_t *bits) override {
         // * Clear the previous sequeces
         my_message_.targets_x().clear();
         my_message_.targets_y().clear();
-        int count = 0;
-        for (int r = 0; r < GAME_HEIGHT; r++) {
-            for (int c = 0; c < GAME_WIDTH; c++) {
-                if ((grid[r][c] >= '0' && grid[r][c] <= '9')) {
-                    my_message_.targets_x().push_back(c);
-                    my_message_.targets_y().push_back(r);
-                    count++;
-                }
-            }
+        // * Visit only the targets, a word of the bitset at a time
+        for (int i = bitgrid_next(bits, 0); i >= 0; i = bitgrid_next(bits, i + 1)) {
+            my_message_.targets_x().push_back(i % GAME_WIDTH);
+            my_message_.targets_y().push_back(i / GAME_WIDTH);
         }
-        my_message_.targets_number(count);
-        int flag = 0;
-        while (!flag || keep_running) {
-            if (listener_.matched_ > 0) {
-                writer_->write(&my_message_);
-                Duration_t timeout;
-                timeout.seconds = 5;
-                timeout.nanosec = 0;
-                writer_->wait_for_acknowledgments(timeout);
-                flag = 1;
-            }
-        }
-        return true;
+        my_message_.targets_number(bitgrid_count(bits));
+        return &my_message_;
     }
 
+public:
+    CustomTargetsPublisher() : MapPublisher(targets_topics, new TargetsPubSubType()) {}
+
     void run(int read_fd) {
         srand(static_cast<unsigned int>(time(NULL)));
         while (keep_running) {
-            char grid[GAME_HEIGHT][GAME_WIDTH];
-            memset(grid, ' ', GAME_HEIGHT*GAME_WIDTH);
-            if (read(read_fd, grid, GAME_HEIGHT * GAME_WIDTH * sizeof(char)) == -1) {
-                perror("read");
-                EXIT_FAILURE;
+            // * Obstacles of the map, as bitsets (blocks until Obstacles makes a new map)
+            bitgrid_t cells;
+            bitgrid_clear(&cells);
+            const ssize_t bytes = read(read_fd, &cells, sizeof(cells));
+            if (bytes == -1 && errno == EINTR) {
+                continue;
+            }
+            if (bytes != sizeof(cells)) {
+                // * Obstacles closed the pipe (or an error): there will be no new map
+                if (bytes == -1) perror("read");
+                break;
             }
             // * Generate targets (decreasing from '9' to '0')
             char num_target = '9';
@@ -176,12 +74,13 @@ public:
                 int x = (rand() % (GAME_WIDTH - 2)) + 1;
                 int y = (rand() % (GAME_HEIGHT - 2)) + 1;
                 // * Excise the center of the map (the drone will be there at the beginning)
-                if (grid[y][x] == ' ' && !(x == GAME_WIDTH / 2 && y == GAME_HEIGHT / 2)) {
-                    grid[y][x] = num_target;
+                if (bitgrid_cell(&cells, x, y) == CELL_EMPTY && !(x == GAME_WIDTH / 2 && y == GAME_HEIGHT / 2)) {
+                    bitgrid_set(cells.targets, bitgrid_index(x, y));
                     num_target--;
                 }
             }
-            publish_from_grid(grid);
+            // * Publish on change, at once: a Blackboard matched later gets the last map from the writers
+            publish_from_grid(&cells);
         }
     }
 };
@@ -241,7 +140,7 @@ int main (int argc, char *argv[]) {
     }
 
     CustomTargetsPublisher* mypub = new CustomTargetsPublisher();
-    if (mypub->init()) {
+    if (mypub->init(logfile)) {
         mypub->run(read_fd);
     } else {
         std::cerr << "Publisher initialization failed." << std::endl;
@@ -0,0 +1,92 @@
+//
+// Created by Gian Marco Balia
+//
+// src/telemetry_shm.c
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "telemetry_shm.h"
+
+int telemetry_shm_create(void) {
+    /*
+     * Create (or reset) the shared status page, empty.
+     * @return 0 on success, -1 on failure.
+    */
+    const int fd = shm_open(TELEMETRY_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (fd == -1) {
+        perror("shm_open telemetry");
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(telemetry_shm_t)) == -1) {
+        perror("ftruncate telemetry");
+        close(fd);
+        return -1;
+    }
+    telemetry_shm_t *page = mmap(NULL, sizeof(telemetry_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        perror("mmap telemetry");
+        return -1;
+    }
+    page->lock.sequence = 0;
+    memset(&page->data, 0, sizeof(page->data));
+    munmap(page, sizeof(telemetry_shm_t));
+    return 0;
+}
+
+telemetry_shm_t *telemetry_shm_open(const int writable) {
+    /*
+     * Map the shared status page created by telemetry_shm_create.
+     * @param writable 1 for the writer (Blackboard), 0 for readers.
+     * @return Pointer to the mapped page, NULL on failure.
+    */
+    const int fd = shm_open(TELEMETRY_SHM_NAME, writable ? O_RDWR : O_RDONLY, 0);
+    if (fd == -1) {
+        perror("shm_open telemetry");
+        return NULL;
+    }
+    telemetry_shm_t *page = mmap(NULL, sizeof(telemetry_shm_t), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+        MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        perror("mmap telemetry");
+        return NULL;
+    }
+    return page;
+}
+
+void telemetry_shm_close(telemetry_shm_t *page) {
+    if (page) {
+        munmap(page, sizeof(telemetry_shm_t));
+    }
+}
+
+void telemetry_shm_unlink(void) {
+    shm_unlink(TELEMETRY_SHM_NAME);
+}
+
+void telemetry_shm_publish(telemetry_shm_t *page, const telemetry_t *data) {
+    /*
+     * Copy a new status in the page.
+     * @param page Page mapped as writable.
+     * @param data The status.
+    */
+    seqlock_write_begin(&page->lock);
+    page->data = *data;
+    seqlock_write_end(&page->lock);
+}
+
+void telemetry_shm_read(const telemetry_shm_t *page, telemetry_t *data) {
+    /*
+     * Copy a consistent status out of the page, retrying if the writer updated it meanwhile.
+     * @param page Page mapped by a reader.
+     * @param data The status.
+    */
+    uint32_t sequence;
+    do {
+        sequence = seqlock_read_begin(&page->lock);
+        memcpy(data, (const void *)&page->data, sizeof(*data));
+    } while (seqlock_read_retry(&page->lock, sequence));
+}
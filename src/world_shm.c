@@ -0,0 +1,79 @@
+//
+// Created by Gian Marco Balia
+//
+// src/world_shm.c
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "world_shm.h"
+
+int world_shm_create(void) {
+    /*
+     * Create (or reset) the shared world segment with an empty grid.
+     * @return 0 on success, -1 on failure.
+    */
+    const int fd = shm_open(WORLD_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (fd == -1) {
+        perror("shm_open world");
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(world_shm_t)) == -1) {
+        perror("ftruncate world");
+        close(fd);
+        return -1;
+    }
+    world_shm_t *world = mmap(NULL, sizeof(world_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (world == MAP_FAILED) {
+        perror("mmap world");
+        return -1;
+    }
+    world->lock.sequence = 0;
+    memset(&world->cells, 0, sizeof(world->cells));
+    munmap(world, sizeof(world_shm_t));
+    return 0;
+}
+
+world_shm_t *world_shm_open(const int writable) {
+    /*
+     * Map the shared world segment created by world_shm_create.
+     * @param writable 1 for the writer (Blackboard), 0 for readers.
+     * @return Pointer to the mapped segment, NULL on failure.
+    */
+    const int fd = shm_open(WORLD_SHM_NAME, writable ? O_RDWR : O_RDONLY, 0);
+    if (fd == -1) {
+        perror("shm_open world");
+        return NULL;
+    }
+    world_shm_t *world = mmap(NULL, sizeof(world_shm_t), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+        MAP_SHARED, fd, 0);
+    close(fd);
+    if (world == MAP_FAILED) {
+        perror("mmap world");
+        return NULL;
+    }
+    return world;
+}
+
+void world_shm_close(world_shm_t *world) {
+    if (world) {
+        munmap(world, sizeof(world_shm_t));
+    }
+}
+
+void world_shm_unlink(void) {
+    shm_unlink(WORLD_SHM_NAME);
+}
+
+void world_shm_publish(world_shm_t *world, const bitgrid_t *cells) {
+    /*
+     * Copy a new version of the grid in the segment.
+     * @param world Segment mapped as writable.
+     * @param cells The updated grid.
+    */
+    seqlock_write_begin(&world->lock);
+    world->cells = *cells;
+    seqlock_write_end(&world->lock);
+}
@@ -0,0 +1,98 @@
+//
+// Created by Gian Marco Balia
+//
+// tests/dronesim_map_test.c
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "macros.h"
+#include "dronesim.h"
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures++; \
+    } \
+} while (0)
+
+static int same_field(const force_field_t *field, const bitgrid_t *cells) {
+    // * The incremental field must match the one built from scratch on the same cells
+    static force_field_t built;
+    force_field_build(&built, cells);
+    for (int row = 0; row < GAME_HEIGHT; row++) {
+        for (int col = 0; col < GAME_WIDTH; col++) {
+            if (fabs(field->fx[row][col] - built.fx[row][col]) > 1e-9 ||
+                fabs(field->fy[row][col] - built.fy[row][col]) > 1e-9) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    /*
+     * Headless checks of the maps loaded into a game in progress (dronesim_load_map): a taken target stays
+     * taken, the targets left keep their digits, the obstacles follow the new map but never land on the drone.
+    */
+    static char grid[GAME_HEIGHT][GAME_WIDTH];
+    static dronesim_state_t game;
+    const int cx = GAME_WIDTH / 2, cy = GAME_HEIGHT / 2;
+    memset(grid, ' ', sizeof(grid));
+    grid[cy][cx + 2] = '7';
+    grid[cy + 20][cx - 20] = '3';
+    grid[cy - 20][cx + 20] = '5';
+    grid[10][10] = 'o';
+    grid[10][20] = 'o';
+    dronesim_reset(&game, grid);
+    CHECK(game.count_targets == 3);
+    CHECK(game.count_obstacles == 2);
+
+    // * Take the target two cells on the right of the drone
+    const double pos[4] = {cx, cy, cx + 2, cy};
+    dronesim_apply_move(&game, pos, PHYSICS_SUBSTEPS);
+    CHECK(game.count_targets == 2);
+    CHECK(bitgrid_cell(&game.cells, cx + 2, cy) == CELL_EMPTY);
+    force_field_update(&game.field, &game.cells);
+
+    // * The same map again: the target does not come back
+    CHECK(dronesim_load_map(&game, grid) == 0);
+    CHECK(game.count_targets == 2);
+    CHECK(bitgrid_cell(&game.cells, cx + 2, cy) == CELL_EMPTY);
+    CHECK(game.grid[cy][cx + 2] == ' ');
+
+    // * A new map: its obstacles replace the old ones, its targets wait for the next game
+    static char next[GAME_HEIGHT][GAME_WIDTH];
+    memset(next, ' ', sizeof(next));
+    next[10][10] = 'o';
+    next[30][40] = 'o';
+    next[cy + 20][cx - 20] = 'o';           // * On a target left: the target keeps its cell
+    next[cy][cx + 3] = 'o';                 // * Next to the drone
+    next[60][60] = '1';
+    CHECK(dronesim_load_map(&game, next) == 2);
+    CHECK(game.count_obstacles == 2);
+    CHECK(game.count_targets == 2);
+    CHECK(game.grid[10][20] == ' ' && game.grid[30][40] == 'o');
+    CHECK(game.grid[cy + 20][cx - 20] == '3' && game.grid[cy - 20][cx + 20] == '5');
+    CHECK(bitgrid_cell(&game.cells, cx + 3, cy) == CELL_EMPTY);
+    CHECK(bitgrid_cell(&game.cells, 60, 60) == CELL_EMPTY);
+    CHECK(same_field(&game.field, &game.cells));
+
+    // * Taking the targets left still wins the game
+    const double first[4] = {cx + 2, cy, cx - 20, cy + 20};
+    dronesim_apply_move(&game, first, PHYSICS_SUBSTEPS);
+    const double second[4] = {cx - 20, cy + 20, cx + 20, cy - 20};
+    dronesim_apply_move(&game, second, PHYSICS_SUBSTEPS);
+    CHECK(game.count_targets == 0);
+    CHECK(game.outcome == DRONESIM_WON);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("dronesim_map_test: all checks passed\n");
+    return EXIT_SUCCESS;
+}
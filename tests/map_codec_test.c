@@ -0,0 +1,117 @@
+//
+// Created by Gian Marco Balia
+//
+// tests/map_codec_test.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "macros.h"
+#include "map_codec.h"
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures++; \
+    } \
+} while (0)
+
+static uint8_t payload[MAP_CODEC_MAX_BYTES + 16];
+static int32_t xs[BITGRID_CELLS], ys[BITGRID_CELLS];
+
+static int decode(const uint8_t encoding, const size_t size, const int count) {
+    return map_codec_decode(encoding, payload, size, GAME_WIDTH, GAME_HEIGHT, count, xs, ys);
+}
+
+static int round_trip(const uint64_t *bits) {
+    // * Encode the layer, decode it back and compare the cells, in row-major order
+    uint8_t encoding;
+    const size_t size = map_codec_encode(bits, payload, &encoding);
+    const int count = bitgrid_count(bits);
+    if (size > 4 * (size_t)count || size > MAP_CODEC_MAX_BYTES || decode(encoding, size, count) != 0) {
+        return 0;
+    }
+    int k = 0;
+    for (int i = bitgrid_next(bits, 0); i >= 0; i = bitgrid_next(bits, i + 1), k++) {
+        if (xs[k] != i % GAME_WIDTH || ys[k] != i / GAME_WIDTH) return 0;
+    }
+    return k == count;
+}
+
+int main(void) {
+    /*
+     * Headless checks of the compact map payload: every kind of layer survives an encode and decode, and the
+     * decoder rejects the payloads that do not match their header instead of reading past them.
+    */
+    static bitgrid_t cells;
+
+    // * Empty, sparse, dense and full layers
+    bitgrid_clear(&cells);
+    CHECK(round_trip(cells.obstacles));
+    for (int i = 0; i < 20; i++) {
+        bitgrid_set(cells.obstacles, bitgrid_index((i * 37) % GAME_WIDTH, (i * 53) % GAME_HEIGHT));
+    }
+    CHECK(round_trip(cells.obstacles));
+    bitgrid_clear(&cells);
+    srand(7);
+    for (int i = 0; i < BITGRID_CELLS; i++) {
+        if (rand() % 2) bitgrid_set(cells.obstacles, i);
+    }
+    CHECK(round_trip(cells.obstacles));
+    for (int i = 0; i < BITGRID_CELLS; i++) {
+        bitgrid_set(cells.obstacles, i);
+    }
+    CHECK(round_trip(cells.obstacles));
+    uint8_t encoding;
+    CHECK(map_codec_encode(cells.obstacles, payload, &encoding) == 3 && encoding == MAP_ENCODING_RLE);
+    bitgrid_set(cells.targets, BITGRID_CELLS - 1);
+    CHECK(round_trip(cells.targets));
+
+    // * A map of pairs, (3, 4) and the last cell: truncated, overlong, off the map
+    const uint8_t pairs[] = {3, 0, 4, 0, GAME_WIDTH - 1, 0, GAME_HEIGHT - 1, 0};
+    memcpy(payload, pairs, sizeof(pairs));
+    CHECK(decode(MAP_ENCODING_PAIRS, sizeof(pairs), 2) == 0);
+    CHECK(xs[0] == 3 && ys[0] == 4 && xs[1] == GAME_WIDTH - 1 && ys[1] == GAME_HEIGHT - 1);
+    CHECK(decode(MAP_ENCODING_PAIRS, sizeof(pairs) - 1, 2) == -1);
+    CHECK(decode(MAP_ENCODING_PAIRS, sizeof(pairs) + 4, 2) == -1);
+    CHECK(decode(MAP_ENCODING_PAIRS, sizeof(pairs), 3) == -1);
+    payload[0] = GAME_WIDTH;
+    CHECK(decode(MAP_ENCODING_PAIRS, sizeof(pairs), 2) == -1);
+
+    // * A map of runs: truncated, overlong, a run past the count or the map
+    bitgrid_clear(&cells);
+    for (int i = 0; i < 300; i++) {
+        bitgrid_set(cells.obstacles, 1000 + i);
+    }
+    size_t size = map_codec_encode(cells.obstacles, payload, &encoding);
+    CHECK(encoding == MAP_ENCODING_RLE);
+    CHECK(decode(encoding, size, 300) == 0);
+    CHECK(decode(encoding, size - 1, 300) == -1);
+    CHECK(decode(encoding, size, 299) == -1);
+    CHECK(decode(encoding, size, 301) == -1);
+    payload[size] = 0;
+    CHECK(decode(encoding, size + 1, 300) == -1);
+    payload[size + 1] = 0;
+    CHECK(decode(encoding, size + 2, 300) == -1);
+    const uint8_t past_map[] = {0x8f, 0x4e, 0x02};    // * Empty run of 9999 cells, then 2 occupied
+    memcpy(payload, past_map, sizeof(past_map));
+    CHECK(decode(MAP_ENCODING_RLE, sizeof(past_map), 2) == -1);
+    const uint8_t overlong[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x01};
+    memcpy(payload, overlong, sizeof(overlong));
+    CHECK(decode(MAP_ENCODING_RLE, sizeof(overlong), 1) == -1);
+
+    // * Unknown encoding and headers that do not fit a map
+    size = map_codec_encode(cells.obstacles, payload, &encoding);
+    CHECK(decode(7, size, 300) == -1);
+    CHECK(map_codec_decode(encoding, payload, size, 0, GAME_HEIGHT, 300, xs, ys) == -1);
+    CHECK(map_codec_decode(encoding, payload, size, MAP_CODEC_MAX_CELLS, 2, 300, xs, ys) == -1);
+    CHECK(decode(encoding, size, -1) == -1);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("map_codec_test: all checks passed\n");
+    return EXIT_SUCCESS;
+}